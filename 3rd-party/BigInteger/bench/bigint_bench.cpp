@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ElGamal.h"
+#include "big_integer.h"
+
+
+/// Times BigInteger kernels over operand sizes from --min-bits to --max-bits (doubling).
+/// Every kernel is repeated until --min-time seconds have passed; the output is one
+/// row per (operation, bits) in CSV or JSON, to be diffed with compare.py.
+/// Kernels which grow faster than quadratically (modpow, conversions through base 2)
+/// stop at kSlowKernelMaxBits unless --full is given: at 16384 bits they take hours.
+/// Elliptic-curve kernels run once per built-in curve, with bits = size of its field.
+
+namespace {
+
+/// Exposes the protected multiplication tiers.
+struct Kernels : BigInteger {
+    using BigInteger::NativeMultiplication;
+    using BigInteger::KaratsubaMultiplication;
+    using BigInteger::kKaratsubaThreshold;
+};
+
+constexpr int kSlowKernelMaxBits = 1024;
+
+struct Kernel {
+    std::string operation;
+    bool is_slow;
+    std::function<void()> run;
+};
+
+struct Options {
+    int min_bits = 64;
+    int max_bits = 16384;
+    double min_time = 0.2;
+    bool json = false;
+    bool full = false;
+    std::string filter;
+};
+
+struct Result {
+    std::string operation;
+    int bits;
+    long long iterations;
+    double ns_per_op;
+};
+
+/// Base 2 record of a random number in [2^(bits-1), 2^bits).
+std::string GetRandomBinary(std::mt19937_64& gen, int bits) {
+    std::string binary(bits, '0');
+    binary[0] = '1';
+    for (int i = 1; i < bits; ++i) {
+        binary[i] = static_cast<char>('0' + (gen() & 1));
+    }
+    return binary;
+}
+
+/// The same number in the big-endian format of GetByte().
+std::string GetBytesFromBinary(const std::string& binary) {
+    std::string bytes;
+    int value = 0;
+    for (size_t i = 0; i < binary.size(); ++i) {
+        value = value * 2 + (binary[i] - '0');
+        if ((binary.size() - i - 1) % 8 == 0) {
+            bytes += static_cast<char>(value);
+            value = 0;
+        }
+    }
+    return bytes;
+}
+
+BigInteger GetRandomNumber(std::mt19937_64& gen, int bits) {
+    return BigInteger::GetFromBase2(GetRandomBinary(gen, bits));
+}
+
+Result Measure(const std::string& operation, int bits, double min_time, const std::function<void()>& kernel) {
+    using Clock = std::chrono::steady_clock;
+
+    long long iterations = 0;
+    const auto start_time = Clock::now();
+    double elapsed = 0;
+    do {
+        kernel();
+        ++iterations;
+        elapsed = std::chrono::duration<double>(Clock::now() - start_time).count();
+    } while (elapsed < min_time);
+
+    return Result{operation, bits, iterations, elapsed * 1e9 / static_cast<double>(iterations)};
+}
+
+Options ParseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string option = argv[i];
+        if (option == "--json") {
+            options.json = true;
+        } else if (option == "--full") {
+            options.full = true;
+        } else if (option == "--csv") {
+            options.json = false;
+        } else if (option == "--min-bits" && i + 1 < argc) {
+            options.min_bits = std::max(8, std::atoi(argv[++i]));
+        } else if (option == "--max-bits" && i + 1 < argc) {
+            options.max_bits = std::atoi(argv[++i]);
+        } else if (option == "--min-time" && i + 1 < argc) {
+            options.min_time = std::atof(argv[++i]);
+        } else if (option == "--filter" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--csv | --json] [--min-bits B] [--max-bits B] "
+                      << "[--min-time SECONDS] [--filter SUBSTRING] [--full]" << std::endl;
+            std::exit(1);
+        }
+    }
+    return options;
+}
+
+void PrintResults(const std::vector<Result>& results, bool json) {
+    if (json) {
+        printf("{\"karatsuba_threshold\": %zu, \"results\": [\n", Kernels::kKaratsubaThreshold);
+        for (size_t i = 0; i < results.size(); ++i) {
+            printf("  {\"operation\": \"%s\", \"bits\": %d, \"iterations\": %lld, \"ns_per_op\": %.1f}%s\n",
+                   results[i].operation.c_str(), results[i].bits, results[i].iterations,
+                   results[i].ns_per_op, i + 1 < results.size() ? "," : "");
+        }
+        printf("]}\n");
+        return;
+    }
+
+    printf("operation,bits,iterations,ns_per_op\n");
+    for (const auto& result : results) {
+        printf("%s,%d,%lld,%.1f\n", result.operation.c_str(), result.bits, result.iterations, result.ns_per_op);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const Options options = ParseOptions(argc, argv);
+
+    std::mt19937_64 gen(2023);
+    std::vector<Result> results;
+
+    for (int bits = options.min_bits; bits <= options.max_bits; bits *= 2) {
+        const std::string binary = GetRandomBinary(gen, bits);
+        const std::string bytes = GetBytesFromBinary(binary);
+        const BigInteger a = BigInteger::GetFromBase2(binary);
+        const BigInteger b = GetRandomNumber(gen, bits);
+        const BigInteger wide = GetRandomNumber(gen, 2 * bits);
+        const BigInteger md = GetRandomNumber(gen, bits) + 1;
+        const std::string decimal = a.ToString();
+        std::vector<unsigned char> packed(a.GetPackedDigitsSize());
+        const std::vector<BigInteger> multi_pow_bases = {a, b};
+        const std::vector<BigInteger> multi_pow_exponents = {b, a};
+
+        const std::vector<Kernel> kernels = {
+            {"add", false, [&] { BigInteger r = a + b; }},
+            {"sub", false, [&] { BigInteger r = a - b; }},
+            {"mul_native", false, [&] { BigInteger r = Kernels::NativeMultiplication(a, b); }},
+            {"mul_karatsuba", false, [&] { BigInteger r = Kernels::KaratsubaMultiplication(a, b); }},
+            {"mul", false, [&] { BigInteger r = a * b; }},
+            {"square", false, [&] { BigInteger r = a * a; }},
+            {"div", false, [&] { BigInteger r = wide / a; }},
+            {"mod", false, [&] { BigInteger r = BigInteger::mod(wide, md); }},
+            {"modpow", true, [&] { BigInteger r = BigInteger::pow(a, b, md); }},
+            {"multipow2", true, [&] { BigInteger r = BigInteger::multiPow(multi_pow_bases, multi_pow_exponents, md); }},
+            {"gcd", false, [&] { BigInteger r = BigInteger::gcd(a, b); }},
+            {"to_decimal", false, [&] { std::string r = a.ToString(); }},
+            {"from_decimal", false, [&] { BigInteger r(decimal); }},
+            {"to_base2", true, [&] { std::string r = a.GetBase2(); }},
+            {"from_base2", false, [&] { BigInteger r = BigInteger::GetFromBase2(binary); }},
+            {"to_byte", true, [&] { std::string r = a.GetByte(); }},
+            {"from_byte", false, [&] { BigInteger r = BigInteger::GetFromByte(bytes); }},
+            {"to_packed", false, [&] { a.WritePackedDigits(packed.data(), packed.size()); }},
+            {"from_packed", false, [&] { auto r = BigInteger::GetFromPackedDigits(packed.data(), packed.size()); }},
+        };
+
+        for (const auto& kernel : kernels) {
+            if (kernel.operation.find(options.filter) == std::string::npos) {
+                continue;
+            }
+            if (kernel.is_slow && !options.full && bits > kSlowKernelMaxBits) {
+                continue;
+            }
+            results.push_back(Measure(kernel.operation, bits, options.min_time, kernel.run));
+            std::cerr << kernel.operation << " " << bits << " bits: " << results.back().ns_per_op << " ns" << std::endl;
+        }
+    }
+
+    for (const auto& name : ElGamal::CurveParams::GetNames()) {
+        const ElGamal::CurveParams& curve = *ElGamal::CurveParams::Find(name);
+        const int bits = static_cast<int>(curve.p.GetLittleEndianBytes().size() * 8);
+        const BigInteger scalar = BigInteger::GetFromBase2(GetRandomBinary(gen, bits)) % curve.N;
+        const ElGamal::Point point = curve.G * 3;
+        // Builds the generator table outside of the measurement
+        curve.multiplyGenerator(1);
+
+        const std::vector<Kernel> kernels = {
+            {"ec_mul", false, [&] { ElGamal::Point r = point * scalar; }},
+            {"ec_mul_ladder", false, [&] { ElGamal::Point r = point.multiplyConstantTime(scalar); }},
+            {"ec_mul_generator", false, [&] { ElGamal::Point r = curve.multiplyGenerator(scalar); }},
+        };
+        for (const auto& kernel : kernels) {
+            if (kernel.operation.find(options.filter) == std::string::npos) {
+                continue;
+            }
+            results.push_back(Measure(kernel.operation, bits, options.min_time, kernel.run));
+            std::cerr << kernel.operation << " " << name << ": " << results.back().ns_per_op << " ns" << std::endl;
+        }
+    }
+
+    PrintResults(results, options.json);
+    return 0;
+}
@@ -0,0 +1,50 @@
+#!/usr/bin/env python3
+"""Compares two bigint_bench runs (CSV or JSON) operation by operation.
+
+Usage: compare.py BASELINE CANDIDATE [--threshold PERCENT]
+Prints ns/op of both runs and the speedup; rows which changed by more than the
+threshold (5% by default) are marked.
+"""
+
+import argparse
+import csv
+import json
+import sys
+
+
+def load(path):
+    with open(path) as src:
+        text = src.read()
+    if text.lstrip().startswith("{"):
+        rows = json.loads(text)["results"]
+    else:
+        rows = list(csv.DictReader(text.splitlines()))
+    return {(row["operation"], int(row["bits"])): float(row["ns_per_op"]) for row in rows}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline")
+    parser.add_argument("candidate")
+    parser.add_argument("--threshold", type=float, default=5.0)
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    candidate = load(args.candidate)
+
+    print(f"{'operation':<16}{'bits':>8}{'baseline ns':>16}{'candidate ns':>16}{'speedup':>10}")
+    for key in sorted(baseline.keys() & candidate.keys()):
+        before, after = baseline[key], candidate[key]
+        speedup = before / after if after > 0 else float("inf")
+        mark = ""
+        if abs(speedup - 1) * 100 > args.threshold:
+            mark = "  +" if speedup > 1 else "  -"
+        print(f"{key[0]:<16}{key[1]:>8}{before:>16.1f}{after:>16.1f}{speedup:>9.2f}x{mark}")
+
+    for key in sorted(baseline.keys() ^ candidate.keys()):
+        side = "baseline" if key in baseline else "candidate"
+        print(f"{key[0]} {key[1]} bits: only in {side}", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
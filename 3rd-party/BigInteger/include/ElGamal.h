@@ -1,39 +1,151 @@
 #pragma once
 
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
 #include "big_integer.h"
 #include "crypto_algorithms.h"
+#include "montgomery.h"
 
 
 namespace ElGamal {
 
+class CurveParams;
+struct CurveDefinition;
+
 struct Point {
+    Point(BigInteger x, BigInteger y, const CurveParams& curve);
+
     BigInteger x;
     BigInteger y;
-    
+    /// Curve the point lies on, carried through the arithmetic. Never null;
+    /// a pointer rather than a reference so that points stay assignable.
+    const CurveParams* curve;
+
     bool operator == (const Point& rhs) const;
     bool operator != (const Point& r) const;
-    
+
+    /// The point at infinity is stored as (-1, -1).
+    bool isInfinity() const;
+
+    /// Both go through JacobianPoint and invert only once, when converting the result back.
     Point operator + (const Point& rhs) const;
+    /// Width-w NAF over precomputed odd multiples. Running time depends on step,
+    /// so use multiplyConstantTime for secret scalars.
+    /// REQUIREMENT: step >= 0
     Point operator * (const BigInteger& step) const;
-    
+    /// Montgomery ladder over a fixed number of bits (those of the group order N):
+    /// the same sequence of additions and doublings for every step.
+    /// BigInteger arithmetic itself isn't constant time, so this only removes the
+    /// scalar-dependent branching of operator *.
+    /// REQUIREMENT: step >= 0, the point lies on the curve
+    Point multiplyConstantTime(const BigInteger& step) const;
+
     friend std::ostream& operator << (std::ostream& os, const Point& a);
 };
 
-static BigInteger parseHexadecimal(const std::string& hex);
+/// (x, y, z) stands for the affine point (x / z^2, y / z^3) mod p; z == 0 is the point at infinity.
+/// Coordinates are kept in the Montgomery form of curve->field, reduced to [0, p).
+struct JacobianPoint {
+    BigInteger x;
+    BigInteger y;
+    BigInteger z;
+    /// Never null, as in Point.
+    const CurveParams* curve;
+
+    JacobianPoint(BigInteger x, BigInteger y, BigInteger z, const CurveParams& curve);
+
+    static JacobianPoint FromAffine(const Point& point);
+    static JacobianPoint Infinity(const CurveParams& curve);
+    /// Costs one modular inversion.
+    Point toAffine() const;
+    /// Affine forms of all points for a single inversion (Montgomery's trick): the product
+    /// of all z is inverted once and each 1 / z is peeled off with two multiplications.
+    /// REQUIREMENT: all points lie on the same curve
+    static std::vector<Point> ToAffineBatch(std::span<const JacobianPoint> points);
+
+    /// Point::operator * and Point::multiplyConstantTime without the final inversion.
+    static JacobianPoint Multiply(const Point& point, const BigInteger& step);
+    static JacobianPoint MultiplyConstantTime(const Point& point, const BigInteger& step);
+
+    bool isInfinity() const;
+
+    /// Uses the cheaper a = -3 formula when the curve allows it.
+    JacobianPoint twice() const;
+    JacobianPoint negate() const;
+    JacobianPoint operator + (const JacobianPoint& rhs) const;
+    /// Mixed addition: rhs is affine, so z2 = 1 saves four multiplications.
+    JacobianPoint operator + (const Point& rhs) const;
+};
+
+/// Short Weierstrass curve y^2 = x^3 + Ax + B over F_p with a generator G of prime order N.
+/// BigInteger can't be a compile-time constant, so the SEC 2 domain parameters are kept as
+/// decimal strings and parsed at run time, once, when the curves are first created.
+/// Curves are created together on first use, never destroyed and safe to share between threads.
+class CurveParams {
+  public:
+    /// The curve used by Bob and Emulate.
+    static const CurveParams& Secp112r1();
+    /// SEC 2 name (secp112r1, secp128r1, secp160r1, secp192r1, secp256r1); nullptr if unknown.
+    static const CurveParams* Find(const std::string& name);
+    static std::vector<std::string> GetNames();
+
+    CurveParams(const CurveParams&) = delete;
+    CurveParams& operator = (const CurveParams&) = delete;
+
+    /// step * G using a table of j * 16^i * G built once on first use and then shared
+    /// read-only by all threads: one mixed addition per 4-bit window of step, no doublings.
+    /// step is reduced mod N first. Every window reads its whole table row and makes its
+    /// addition, zero windows included, so the sequence of operations is the same for every
+    /// step; as with multiplyConstantTime, BigInteger arithmetic itself isn't constant time.
+    /// REQUIREMENT: step >= 0
+    Point multiplyGenerator(const BigInteger& step) const;
+    JacobianPoint multiplyGeneratorJacobian(const BigInteger& step) const;
+
+    const std::string name;
+    const BigInteger p;
+    const BigInteger A;
+    const BigInteger B;
+    const BigInteger N;
+    const Point G;
+    const Point O;
+
+    /// Arithmetic mod p used by JacobianPoint.
+    const MontgomeryContext field;
+    /// A and 1 in the Montgomery form of field.
+    const BigInteger montgomery_a;
+    const BigInteger montgomery_one;
+    /// A = p - 3 allows the cheaper doubling.
+    const bool a_is_minus_three;
+
+  private:
+    explicit CurveParams(const CurveDefinition& definition);
+
+    mutable std::once_flag generator_table_flag_;
+    /// generator_table_[i * 15 + j - 1] = j * 16^i * G, affine, for every nibble of N.
+    mutable std::vector<Point> generator_table_;
+};
 
 class Bob {
 private:
     BigInteger k;
 
 public:
-    Bob();
+    explicit Bob(const CurveParams& curve = CurveParams::Secp112r1());
 
     Point decode(const std::pair<Point, Point>& code);
 
     Point Y;
 };
 
+/// Uses the curve of key.
 std::pair<Point, Point> encode(const Point& M, const Point& key);
+/// encode for every message under the same key, on threads_count threads (0 = all cores).
+/// Each thread keeps its results projective and normalizes them all with one inversion.
+std::vector<std::pair<Point, Point>> encodeBatch(std::span<const Point> messages, const Point& key,
+                                                 size_t threads_count = 0);
 
 void Emulate();
 
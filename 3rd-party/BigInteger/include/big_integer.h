@@ -3,10 +3,16 @@
 #include <string>
 #include <vector>
 #include <iostream>
+#include <optional>
+
+#include "digit_allocator.h"
+#include "instrumentation.h"
 
 class BigInteger {
   public:
     using Digit = unsigned char;
+    /// Least significant digit first. Storage follows the thread's DigitResource.
+    using Digits = std::vector<Digit, DigitAllocator<Digit>>;
 
     BigInteger() : BigInteger(0) {}
     BigInteger(const BigInteger& other);
@@ -18,8 +24,11 @@ class BigInteger {
     Digit getDigitAt(int pos) const;
 
     static BigInteger zero();
-    const std::vector<Digit>& data() const;
+    const Digits& data() const;
     size_t getLength() const;
+    /// |this| mod 10^count and |this| / 10^count: digit slicing, no division.
+    BigInteger getLowDigits(size_t count) const;
+    BigInteger dropLowDigits(size_t count) const;
 
     bool IsPositive() const;
     bool IsEven() const;
@@ -32,6 +41,15 @@ class BigInteger {
     std::string GetHex() const;
     std::string GetBase64() const;
     std::string GetByte() const;
+    /// Base 256 of the absolute value, least significant byte first, no trailing zero bytes
+    /// (empty for zero). Linear in the number of digits per 7 produced bytes.
+    std::string GetLittleEndianBytes() const;
+
+    /// Packed decimal: two digits per byte, least significant digit in the low nibble of dst[0].
+    size_t GetPackedDigitsSize() const;
+    /// Writes the absolute value padded with zeros to width bytes.
+    /// REQUIREMENT: width >= GetPackedDigitsSize()
+    void WritePackedDigits(unsigned char* dst, size_t width) const;
 
     bool operator == (long long other) const;
     bool operator == (const BigInteger& other) const;
@@ -76,6 +94,11 @@ class BigInteger {
     static BigInteger pow(const BigInteger& number, const BigInteger& power);
     static BigInteger pow(const BigInteger& number, const BigInteger& power,
                          const BigInteger& md);
+    /// prod(bases[i] ^ exponents[i]) % md with shared squarings.
+    /// REQUIREMENT: exponents are non-negative, md is positive
+    static BigInteger multiPow(const std::vector<BigInteger>& bases,
+                               const std::vector<BigInteger>& exponents,
+                               const BigInteger& md);
 
     static BigInteger sqrt(const BigInteger& number);
 
@@ -89,11 +112,16 @@ class BigInteger {
     static BigInteger GetFromBase2(const std::string& src);
     static BigInteger GetFromBase64(const std::string& src);
     static BigInteger GetFromByte(const std::string& src);
+    /// Reads size bytes, least significant first.
+    static BigInteger GetFromLittleEndianBytes(const unsigned char* src, size_t size);
+    /// Reads a non-negative number written by WritePackedDigits.
+    /// Returns std::nullopt if some nibble isn't a decimal digit.
+    static std::optional<BigInteger> GetFromPackedDigits(const unsigned char* src, size_t width);
 
 protected:
     struct DivisionResult {
-        std::vector<Digit> quotient;
-        std::vector<Digit> remainder;
+        Digits quotient;
+        Digits remainder;
     };
 
     enum class CompareSign {
@@ -102,26 +130,40 @@ protected:
         GREATER = 1
     };
 
-    BigInteger(const std::vector<Digit>& number) : num_(number) { validate(); }
-    static BigInteger buildByDigitalVector(const std::vector<Digit>& number);
+    BigInteger(const Digits& number) : num_(number) {
+        FS_COUNT(BIGINT_ALLOCATIONS);
+        validate();
+    }
+    static BigInteger buildByDigitalVector(const Digits& number);
 
-    static CompareSign compareUnsignedNumbers(const std::vector<Digit>& lhs,
-                                              const std::vector<Digit>& rhs);
-    static std::vector<Digit> getUnsignedSum(const std::vector<Digit>& lhs,
-                                             const std::vector<Digit>& rhs);
+    static CompareSign compareUnsignedNumbers(const Digits& lhs,
+                                              const Digits& rhs);
+    static Digits getUnsignedSum(const Digits& lhs,
+                                             const Digits& rhs);
     /// REQUIREMENT: LHS has to be not less than RHS
-    static std::vector<Digit> getUnsignedDiff(const std::vector<Digit>& lhs,
-                                              const std::vector<Digit>& rhs);
+    static Digits getUnsignedDiff(const Digits& lhs,
+                                              const Digits& rhs);
     /// REQUIREMENT: RHS can't be equal to zero
     static DivisionResult getUnsignedDivision(BigInteger lhs,
                                               BigInteger rhs);
+    static BigInteger StrausMultiPow(const std::vector<BigInteger>& bases,
+                                     const std::vector<BigInteger>& exponents,
+                                     const BigInteger& md, size_t max_length);
+    static BigInteger PippengerMultiPow(const std::vector<BigInteger>& bases,
+                                        const std::vector<BigInteger>& exponents,
+                                        const BigInteger& md, size_t max_length);
+    /// Operands with at most this many digits are multiplied natively (tune with bigint_bench).
+    static constexpr size_t kKaratsubaThreshold = 100;
+
+    static BigInteger ModularPow(const BigInteger& number, const BigInteger& power,
+                                 const BigInteger& md);
     static BigInteger NativeMultiplication(const BigInteger& lhs, const BigInteger& rhs);
     static BigInteger KaratsubaMultiplication(const BigInteger& lhs, const BigInteger& rhs);
 
     void validateSign();
     void validate();
 
-    std::vector<Digit> num_;
+    Digits num_;
     bool is_positive_{true};
 };
 
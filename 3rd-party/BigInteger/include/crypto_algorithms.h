@@ -1,5 +1,7 @@
 #pragma once
 
+#include <random>
+
 #include "big_integer.h"
 
 
@@ -11,6 +13,20 @@ namespace Crypto {
     BigInteger GetRandomNumberLen(int len);
     BigInteger GetRandomNumberWithBitness(int bitness);
 
+    /// The functions above use rand(): predictable and not meant for several threads.
+    /// These read the kernel CSPRNG (getrandom) instead, need no seeding and are thread-safe.
+    /// Exit the program if the kernel can't provide randomness.
+    void GetSecureRandomBytes(void* buffer, size_t size);
+    bool GetSecureRandomBit();
+    /// Uniform in [min_value, max_value].
+    BigInteger GetSecureRandomNumber(const BigInteger& min_value, const BigInteger& max_value);
+    /// Seeded from the kernel CSPRNG, for a thread that needs a generator of its own.
+    std::mt19937_64 GetSeededRandomEngine();
+
+    /// These draw from gen instead of rand(), so threads that each own an engine may call them.
+    BigInteger GetRandomNumber(const BigInteger& max_value, std::mt19937_64& gen);
+    BigInteger GetRandomNumber(const BigInteger& min_value, const BigInteger& max_value, std::mt19937_64& gen);
+
     BigInteger GetClosestPrimeNumber(const BigInteger& src);
     std::vector<BigInteger> GetRandomPrimeNumbers(const BigInteger& lhs, const BigInteger& rhs, int k = 1);
     std::vector<BigInteger> GetFirstPrimeNumbers(const BigInteger& lhs, const BigInteger& rhs, int k = 1);
@@ -18,11 +34,16 @@ namespace Crypto {
     std::vector<BigInteger> GetFirstPrimeNumbersWithSomeBitness(int bitness, int k = 1);
 
     bool MillerRabinTest(const BigInteger& number);
+    bool MillerRabinTest(const BigInteger& number, std::mt19937_64& gen);
     bool LucasSelfridgeTest(const BigInteger& number);
     bool BPSWTest(const BigInteger& number);
+    bool BPSWTest(const BigInteger& number, std::mt19937_64& gen);
 
+    /// Appends the prime factors of number to result. Divisors come from Brent's variant of the
+    /// rho walk with one gcd per block of steps; each of at most kLimit attempts (-1 = unlimited)
+    /// races threads_count walks on separate threads (0 = all cores).
     void PollardRhoAlgorithm(const BigInteger& number, std::vector<BigInteger>& result,
-                             int kLimit = -1);
+                             int kLimit = -1, size_t threads_count = 1);
 
     std::vector<std::pair<BigInteger, unsigned int>> Factorize(const BigInteger& number);
 
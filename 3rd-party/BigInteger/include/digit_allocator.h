@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/// Pluggable storage for BigInteger digits.
+/// Every digit buffer starts with a small header naming the function that releases it,
+/// so a buffer may outlive the resource's scope and be freed from any thread.
+/// Outside of a DigitResourceScope buffers come from the global heap.
+
+class DigitResource {
+  public:
+    using Release = void (*)(void* block, void* context) noexcept;
+
+    struct Block {
+        void* memory;
+        Release release;
+        void* context;
+    };
+
+    virtual ~DigitResource() = default;
+
+    /// Returned memory has to be aligned to alignof(std::max_align_t).
+    virtual Block allocate(size_t bytes) = 0;
+};
+
+/// Routes digit allocations of the current thread to the resource while alive. Scopes nest.
+class DigitResourceScope {
+  public:
+    explicit DigitResourceScope(DigitResource& resource);
+    /// Routes back to the global heap, e.g. to copy a result out of an arena scope.
+    explicit DigitResourceScope(std::nullptr_t);
+    ~DigitResourceScope();
+
+    DigitResourceScope(const DigitResourceScope&) = delete;
+    DigitResourceScope& operator = (const DigitResourceScope&) = delete;
+
+  private:
+    DigitResource* previous_;
+};
+
+/// Bump arena: an allocation is a pointer increment in the current chunk and freeing is a
+/// counter decrement. reset() rewinds chunks without live buffers; chunks still referenced
+/// (by BigIntegers which escaped the scope) are retired and freed by their last buffer.
+/// Allocates from one thread at a time; buffers may be freed from any thread.
+class DigitArena : public DigitResource {
+  public:
+    static constexpr size_t kChunkSize = 64 * 1024;
+
+    DigitArena() = default;
+    ~DigitArena() override;
+
+    DigitArena(const DigitArena&) = delete;
+    DigitArena& operator = (const DigitArena&) = delete;
+
+    Block allocate(size_t bytes) override;
+    void reset();
+
+    /// Arena of the calling thread, destroyed at thread exit.
+    static DigitArena& forThread();
+
+    /// Routes the thread's digit allocations to forThread() and resets it when the
+    /// outermost Scope ends: wrap a protocol round or a primality test in one.
+    class Scope {
+      public:
+        Scope();
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator = (const Scope&) = delete;
+
+      private:
+        DigitResourceScope resource_scope_;
+    };
+
+  private:
+    struct Chunk {
+        /// Live buffers plus one reference held by the arena.
+        std::atomic<size_t> references{1};
+        size_t capacity{0};
+        size_t used{0};
+    };
+
+    static Chunk* createChunk(size_t capacity);
+    static void releaseChunk(Chunk* chunk) noexcept;
+    static void releaseBlock(void* block, void* context) noexcept;
+
+    std::vector<Chunk*> chunks_;
+    size_t current_{0};
+    int scope_depth_{0};
+};
+
+namespace DigitAllocation {
+    void* Allocate(size_t bytes);
+    void Deallocate(void* ptr) noexcept;
+}  // namespace DigitAllocation
+
+template <typename T>
+struct DigitAllocator {
+    using value_type = T;
+
+    DigitAllocator() = default;
+    template <typename U>
+    DigitAllocator(const DigitAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(DigitAllocation::Allocate(n * sizeof(T)));
+    }
+    void deallocate(T* ptr, size_t) noexcept {
+        DigitAllocation::Deallocate(ptr);
+    }
+
+    template <typename U>
+    bool operator == (const DigitAllocator<U>&) const noexcept { return true; }
+    template <typename U>
+    bool operator != (const DigitAllocator<U>&) const noexcept { return false; }
+};
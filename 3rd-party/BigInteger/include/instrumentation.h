@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// Opt-in counters and latency histograms for the hot paths.
+/// Configure with -DFIATSHAMIR_INSTRUMENTATION=ON to enable; otherwise the FS_* macros
+/// below expand to nothing and instrumented code is compiled exactly as before.
+/// Snapshots can be taken at any time from any thread with ExportPrometheus() / ExportJson().
+
+namespace Instrumentation {
+    enum class Counter {
+        BIGINT_ALLOCATIONS,
+        DIVISIONS,
+        MODULAR_EXPONENTIATIONS
+    };
+    constexpr size_t kCountersCount = 3;
+
+    /// Multiplications are split by the length of the longer operand: class 0 holds
+    /// lengths up to 16 digits, class i up to 16 * 2^i, the last one everything longer.
+    constexpr size_t kMultiplicationSizeClasses = 10;
+
+    /// Counters are kept per thread, so incrementing them never contends.
+    void Increment(Counter counter);
+    void CountMultiplication(size_t digits);
+
+    uint64_t GetCounter(Counter counter);
+    uint64_t GetMultiplications(size_t size_class);
+
+    /// Log-linear histogram of nanoseconds in the HDR style: values below 16 are exact,
+    /// above that every power of two is split into 16 buckets (relative error < 6.25%).
+    class Histogram {
+      public:
+        static constexpr size_t kSubBuckets = 16;
+        static constexpr size_t kBucketsCount = 61 * kSubBuckets;
+
+        explicit Histogram(std::string name);
+
+        void record(uint64_t nanoseconds);
+
+        const std::string& getName() const;
+        uint64_t getCount() const;
+        uint64_t getSum() const;
+        uint64_t getMax() const;
+        /// Upper bound of the bucket holding the q-th quantile, 0 <= q <= 1.
+        uint64_t getValueAtQuantile(double q) const;
+
+      private:
+        static size_t getBucketIndex(uint64_t value);
+        static uint64_t getBucketUpperBound(size_t index);
+
+        std::string name_;
+        std::array<std::atomic<uint64_t>, kBucketsCount> buckets_{};
+        std::atomic<uint64_t> count_{0};
+        std::atomic<uint64_t> sum_{0};
+        std::atomic<uint64_t> max_{0};
+    };
+
+    /// Histogram registered under the name, created on the first call. Never destroyed.
+    Histogram& GetHistogram(const std::string& name);
+
+    /// Records the lifetime of the scope into the histogram.
+    class LatencyScope {
+      public:
+        explicit LatencyScope(Histogram& histogram)
+                : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+        ~LatencyScope() {
+            auto elapsed = std::chrono::steady_clock::now() - start_;
+            histogram_.record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+
+        LatencyScope(const LatencyScope&) = delete;
+        LatencyScope& operator = (const LatencyScope&) = delete;
+
+      private:
+        Histogram& histogram_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    /// Prometheus text exposition format: counters plus one summary per histogram.
+    std::string ExportPrometheus();
+    std::string ExportJson();
+}  // namespace Instrumentation
+
+#ifdef FIATSHAMIR_INSTRUMENTATION
+#define FS_COUNT(counter) ::Instrumentation::Increment(::Instrumentation::Counter::counter)
+#define FS_COUNT_MULTIPLICATION(digits) ::Instrumentation::CountMultiplication(digits)
+/// The line number keeps the names unique, so a scope may hold several latency scopes, one per line.
+#define FS_LATENCY_CONCAT_IMPL(lhs, rhs) lhs##rhs
+#define FS_LATENCY_CONCAT(lhs, rhs) FS_LATENCY_CONCAT_IMPL(lhs, rhs)
+#define FS_LATENCY_SCOPE(name)                                                                  \
+    static ::Instrumentation::Histogram& FS_LATENCY_CONCAT(fs_latency_histogram_, __LINE__) =    \
+            ::Instrumentation::GetHistogram(name);                                              \
+    ::Instrumentation::LatencyScope FS_LATENCY_CONCAT(fs_latency_scope_, __LINE__)(             \
+            FS_LATENCY_CONCAT(fs_latency_histogram_, __LINE__))
+#else
+#define FS_COUNT(counter) ((void)0)
+#define FS_COUNT_MULTIPLICATION(digits) ((void)0)
+#define FS_LATENCY_SCOPE(name) ((void)0)
+#endif
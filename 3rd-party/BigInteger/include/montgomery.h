@@ -0,0 +1,39 @@
+#pragma once
+
+#include "big_integer.h"
+
+/// Montgomery arithmetic modulo m with R = 10^k, k = number of digits of m.
+/// Reduction only slices decimal digits, so a modular multiplication costs three
+/// multiplications and no long division.
+/// REQUIREMENT: m > 1 is coprime with 10
+class MontgomeryContext {
+  public:
+    explicit MontgomeryContext(const BigInteger& module);
+
+    static bool IsSupported(const BigInteger& module);
+
+    const BigInteger& getModule() const;
+
+    /// x * R mod m, 0 <= x < m
+    BigInteger toMontgomery(const BigInteger& x) const;
+    /// x * R mod m for any 0 <= x; without a division when x < m * R
+    BigInteger toMontgomeryWide(const BigInteger& x) const;
+    /// x / R mod m
+    BigInteger fromMontgomery(const BigInteger& x) const;
+    /// a * b / R mod m, both operands in Montgomery form
+    BigInteger multiply(const BigInteger& a, const BigInteger& b) const;
+    /// base ^ exponent in Montgomery form, base in Montgomery form
+    BigInteger pow(const BigInteger& base, const BigInteger& exponent) const;
+
+  private:
+    /// t / R mod m, 0 <= t < m * R
+    BigInteger reduce(const BigInteger& t) const;
+
+    BigInteger module_;
+    size_t digits_;
+    /// -m^(-1) mod R
+    BigInteger module_inverse_;
+    BigInteger r2_;
+    BigInteger r3_;
+    BigInteger module_times_r_;
+};
@@ -4,7 +4,14 @@
 
 #pragma once
 
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <vector>
+
 #include "big_integer.h"
+#include "montgomery.h"
 
 namespace RSA {
 
@@ -16,44 +23,124 @@ struct Key {
 class Bob {
   public:
     void Init(const BigInteger& p, const BigInteger& q);
+    /// Multi-prime RSA: n is the product of all the primes.
+    /// REQUIREMENT: primes are distinct
+    void Init(std::vector<BigInteger> primes);
 
     const BigInteger& GetModule() const;
     const BigInteger& GetPhi() const;
     Key GetPublicKey() const;
     Key GetPrivateKey() const;
 
-    BigInteger Decode(const BigInteger& c);
+    /// k-way CRT decryption with Garner's recombination over the key material precomputed in Init.
+    BigInteger Decode(const BigInteger& c) const;
+    /// Decodes blocks on threads_count threads (0 = all cores); result[i] = Decode(blocks[i]).
+    std::vector<BigInteger> DecodeBatch(std::span<const BigInteger> blocks, size_t threads_count = 0) const;
 
   private:
-    BigInteger p_, q_;
+    struct PrimeFactor {
+        BigInteger prime;
+        /// d mod (prime - 1)
+        BigInteger exponent;
+        /// Empty for primes 2 and 5, which Montgomery reduction in base 10 can't handle
+        std::optional<MontgomeryContext> context;
+        /// inverses[j] = primes[j]^(-1) mod prime for every smaller prime, in Montgomery form if context is set
+        std::vector<BigInteger> inverses;
+    };
+
+    /// c ^ factor.exponent mod factor.prime, c < n
+    static BigInteger DecodeModPrime(const BigInteger& c, const PrimeFactor& factor);
+
     BigInteger n_;
     BigInteger phi_;
     BigInteger e_;
     BigInteger d_;
+
+    /// In ascending order of primes
+    std::vector<PrimeFactor> factors_;
 };
 
 class Alice {
   public:
     void SetPublicKey(const Key& key);
-    BigInteger Encode(const BigInteger& message);
+    const Key& GetPublicKey() const;
+    BigInteger Encode(const BigInteger& message) const;
+    /// Encodes messages on threads_count threads (0 = all cores); result[i] = Encode(messages[i]).
+    std::vector<BigInteger> EncodeBatch(std::span<const BigInteger> messages, size_t threads_count = 0) const;
 
   private:
     Key public_key_;
+    std::optional<MontgomeryContext> context_;
+};
+
+/// Chunked byte input from a std::istream or a file descriptor.
+class ByteReader {
+  public:
+    explicit ByteReader(std::istream& input);
+    explicit ByteReader(int fd);
+
+    /// Reads until size bytes or the end of input; returns the number of bytes read.
+    size_t read(char* dst, size_t size);
+    bool hasFailed() const;
+
+  private:
+    std::istream* input_{nullptr};
+    int fd_{-1};
+    bool has_failed_{false};
 };
 
+/// Chunked byte output to a std::ostream or a file descriptor.
+class ByteWriter {
+  public:
+    explicit ByteWriter(std::ostream& output);
+    explicit ByteWriter(int fd);
+
+    bool write(const char* src, size_t size);
+
+  private:
+    std::ostream* output_{nullptr};
+    int fd_{-1};
+};
+
+/// Block i of a text is bytes [i * symbol_size, (i + 1) * symbol_size), read as a base 256
+/// number with the first byte least significant.
 class TextConvertor {
   public:
     static const int kAlphabetSize = 256;
 
     static std::vector<BigInteger> ConvertFromText(const std::string& text, int symbol_size);
+    /// Drops trailing zero bytes of the block
     static std::string ConvertToText(BigInteger symbols);
 
-  private:
-    static unsigned char ConvertToChar(int number);
-    static int ConvertToNumber(unsigned char c);
+    /// Appends up to max_blocks blocks to blocks, the last one may be shorter.
+    /// Returns the number of bytes consumed, 0 at the end of input.
+    static size_t ReadBlocks(ByteReader& input, int symbol_size, size_t max_blocks,
+                             std::vector<BigInteger>& blocks);
+    /// Writes blocks back as exactly size bytes: symbol_size per block, the rest for the last one.
+    /// Returns false if a block doesn't fit or the output fails.
+    static bool WriteBlocks(ByteWriter& output, std::span<const BigInteger> blocks, int symbol_size, size_t size);
 };
 
+/// Blocks per chunk of the stream pipeline; memory use is bounded by one chunk.
+constexpr size_t kStreamChunkBlocks = 1024;
+
+/// Encrypts the whole input chunk by chunk. Every chunk is written as
+/// [u32 LE plaintext bytes][ciphertext blocks, each as many bytes as n, little-endian].
+/// REQUIREMENT: 256 ^ symbol_size <= n
+bool EncodeStream(const Alice& alice, int symbol_size, ByteReader& input, ByteWriter& output,
+                  size_t threads_count = 0);
+/// Inverse of EncodeStream. Returns false on malformed input or I/O failure.
+bool DecodeStream(const Bob& bob, int symbol_size, ByteReader& input, ByteWriter& output,
+                  size_t threads_count = 0);
+
 Bob MakeBob(int len);
+/// Smallest bitness of a prime in MakeMultiPrimeBob, so that distinct primes are easy to find.
+constexpr int kMinMultiPrimeBitness = 16;
+
+/// primes_count primes of about modulus_bitness / primes_count bits each, searched in parallel,
+/// such that n has exactly modulus_bitness bits.
+/// Returns std::nullopt if primes_count < 2 or a prime would get fewer than kMinMultiPrimeBitness bits.
+std::optional<Bob> MakeMultiPrimeBob(int modulus_bitness, int primes_count);
 BigInteger GetHash(const BigInteger& key, const BigInteger& mod, const std::string& message);
 
 }  // namespace RSA
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/// Scoped trace spans recorded into per-thread ring buffers.
+/// Tracing is off until Enable(); a disabled span costs one relaxed load.
+/// WriteChromeTrace() dumps the spans still held in the buffers as Chrome trace_event
+/// JSON, which chrome://tracing and Perfetto can load. It may run while threads trace.
+
+namespace Tracing {
+    /// Spans kept per thread; older ones are overwritten.
+    constexpr size_t kRingBufferCapacity = 1 << 14;
+
+    void Enable();
+    void Disable();
+    bool IsEnabled();
+
+    /// Returns false if the file can't be written.
+    bool WriteChromeTrace(const std::string& path);
+
+    class Span {
+      public:
+        /// REQUIREMENT: name has static storage duration (a string literal)
+        explicit Span(const char* name);
+        ~Span();
+
+        Span(const Span&) = delete;
+        Span& operator = (const Span&) = delete;
+
+      private:
+        const char* name_{nullptr};
+        uint64_t start_ns_{0};
+    };
+}  // namespace Tracing
+
+/// The line number keeps the span names unique, so a scope may hold several spans, one per line.
+#define FS_TRACE_CONCAT_IMPL(lhs, rhs) lhs##rhs
+#define FS_TRACE_CONCAT(lhs, rhs) FS_TRACE_CONCAT_IMPL(lhs, rhs)
+#define FS_TRACE_SPAN(name) ::Tracing::Span FS_TRACE_CONCAT(fs_trace_span_, __LINE__)(name)
@@ -1,5 +1,11 @@
 #include "ElGamal.h"
 
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
 namespace {
     BigInteger gcd(const BigInteger& a, const BigInteger& b, BigInteger& x, BigInteger& y) {
         if (a == BigInteger::zero()) {
@@ -26,19 +32,79 @@ namespace {
         x = (x % md + md) % md;
         return x;
     }
+
+    /// Bits of |number|, least significant first, read straight from its byte representation.
+    std::vector<unsigned char> getBits(const BigInteger& number) {
+        const std::string bytes = number.GetLittleEndianBytes();
+        std::vector<unsigned char> bits(bytes.size() * 8);
+        for (size_t i = 0; i < bits.size(); ++i) {
+            bits[i] = (static_cast<unsigned char>(bytes[i / 8]) >> (i % 8)) & 1;
+        }
+        while (!bits.empty() && bits.back() == 0) {
+            bits.pop_back();
+        }
+        return bits;
+    }
+
+    /// Width-w non-adjacent form, least significant digit first: every non-zero digit is odd,
+    /// |digit| < 2^(w-1), and any w consecutive digits hold at most one non-zero.
+    std::vector<int> getWindowedNaf(const std::vector<unsigned char>& bits, int width) {
+        std::vector<int> naf(bits.size() + 1, 0);
+        auto bitAt = [&bits](size_t pos) { return pos < bits.size() ? bits[pos] : 0; };
+
+        int carry = 0;
+        size_t pos = 0;
+        while (pos < naf.size()) {
+            if (bitAt(pos) == carry) {
+                ++pos;
+                continue;
+            }
+            int window = carry;
+            for (int i = 0; i < width; ++i) {
+                window += bitAt(pos + i) << i;
+            }
+            carry = (window >> (width - 1)) & 1;
+            naf[pos] = window - (carry << width);
+            pos += width;
+        }
+        while (!naf.empty() && naf.back() == 0) {
+            naf.pop_back();
+        }
+        return naf;
+    }
+
+    /// 4 points precomputed (P, 3P, 5P, 7P); a wider window doesn't pay off at 112 bits.
+    constexpr int kNafWidth = 4;
+
+    /// Fixed-base windows are nibbles: 15 table entries per window.
+    constexpr int kGeneratorWindowBits = 4;
+    constexpr int kGeneratorWindowSize = (1 << kGeneratorWindowBits) - 1;
 }  // namespace
 
 namespace Operators {
     BigInteger mod(BigInteger x, const BigInteger& md) {
-        return ((x % md) + md) % md;
+        x %= md;
+        if (!x.IsPositive()) {
+            x += md;
+        }
+        return x;
     }
 
+    /// sum and diff expect both operands already reduced to [0, md).
     BigInteger sum(const BigInteger& lhs, const BigInteger& rhs, const BigInteger& md) {
-        return mod(lhs + rhs, md);
+        BigInteger result = lhs + rhs;
+        if (result >= md) {
+            result -= md;
+        }
+        return result;
     }
 
     BigInteger diff(const BigInteger& lhs, const BigInteger& rhs, const BigInteger& md) {
-        return mod(lhs - rhs, md);
+        BigInteger result = lhs - rhs;
+        if (!result.IsPositive()) {
+            result += md;
+        }
+        return result;
     }
 
     BigInteger mult(const BigInteger& lhs, const BigInteger& rhs, const BigInteger& md) {
@@ -55,13 +121,151 @@ namespace ElGamal {
 
 using namespace Operators;
 
-Point G = Point{parseHexadecimal("09487239995A5EE76B55F9C2F098"),
-                parseHexadecimal("A89CE5AF8724C0A23E0E0FF77500")};
-Point O = Point{-1, -1};
-BigInteger A = parseHexadecimal("DB7C2ABF62E35E668076BEAD2088");
-BigInteger B = parseHexadecimal("659EF8BA043916EEDE8911702B22");
-BigInteger p = parseHexadecimal("DB7C2ABF62E35E668076BEAD208B");
-BigInteger N = parseHexadecimal("DB7C2ABF62E35E7628DFAC6561C5");
+struct CurveDefinition {
+    const char* name;
+    const char* p;
+    const char* a;
+    const char* b;
+    const char* gx;
+    const char* gy;
+    const char* n;
+};
+
+namespace {
+    /// SEC 2 domain parameters, in decimal because BigInteger stores base-10 digits.
+    constexpr CurveDefinition kCurveDefinitions[] = {
+        {"secp112r1",
+         "4451685225093714772084598273548427",
+         "4451685225093714772084598273548424",
+         "2061118396808653202902996166388514",
+         "188281465057972534892223778713752",
+         "3419875491033170827167861896082688",
+         "4451685225093714776491891542548933"},
+        {"secp128r1",
+         "340282366762482138434845932244680310783",
+         "340282366762482138434845932244680310780",
+         "308990863222245658030922601041482374867",
+         "29408993404948928992877151431649155974",
+         "275621562871047521857442314737465260675",
+         "340282366762482138443322565580356624661"},
+        {"secp160r1",
+         "1461501637330902918203684832716283019653785059327",
+         "1461501637330902918203684832716283019653785059324",
+         "163235791306168110546604919403271579530548345413",
+         "425826231723888350446541592701409065913635568770",
+         "203520114162904107873991457957346892027982641970",
+         "1461501637330902918203687197606826779884643492439"},
+        {"secp192r1",
+         "6277101735386680763835789423207666416083908700390324961279",
+         "6277101735386680763835789423207666416083908700390324961276",
+         "2455155546008943817740293915197451784769108058161191238065",
+         "602046282375688656758213480587526111916698976636884684818",
+         "174050332293622031404857552280219410364023488927386650641",
+         "6277101735386680763835789423176059013767194773182842284081"},
+        {"secp256r1",
+         "115792089210356248762697446949407573530086143415290314195533631308867097853951",
+         "115792089210356248762697446949407573530086143415290314195533631308867097853948",
+         "41058363725152142129326129780047268409114441015993725554835256314039467401291",
+         "48439561293906451759052585252797914202762949526041747995844080717082404635286",
+         "36134250956749795798585127919587881956611106672985015071877198253568414405109",
+         "115792089210356248762697446949407573529996955224135760342422259061068512044369"},
+    };
+}  // namespace
+
+CurveParams::CurveParams(const CurveDefinition& definition)
+        : name(definition.name),
+          p(std::string(definition.p)),
+          A(std::string(definition.a)),
+          B(std::string(definition.b)),
+          N(std::string(definition.n)),
+          G(BigInteger(std::string(definition.gx)), BigInteger(std::string(definition.gy)), *this),
+          O(-1, -1, *this),
+          field(p),
+          montgomery_a(field.toMontgomery(A)),
+          montgomery_one(field.toMontgomery(1)),
+          a_is_minus_three(A + 3 == p) {
+}
+
+const CurveParams& CurveParams::Secp112r1() {
+    static const CurveParams& curve = *Find("secp112r1");
+    return curve;
+}
+
+const CurveParams* CurveParams::Find(const std::string& name) {
+    static const std::vector<std::unique_ptr<const CurveParams>> curves = [] {
+        std::vector<std::unique_ptr<const CurveParams>> result;
+        for (const auto& definition : kCurveDefinitions) {
+            result.emplace_back(new CurveParams(definition));
+        }
+        return result;
+    }();
+
+    for (const auto& curve : curves) {
+        if (curve->name == name) {
+            return curve.get();
+        }
+    }
+    return nullptr;
+}
+
+std::vector<std::string> CurveParams::GetNames() {
+    std::vector<std::string> names;
+    for (const auto& definition : kCurveDefinitions) {
+        names.emplace_back(definition.name);
+    }
+    return names;
+}
+
+Point CurveParams::multiplyGenerator(const BigInteger& step) const {
+    return multiplyGeneratorJacobian(step).toAffine();
+}
+
+JacobianPoint CurveParams::multiplyGeneratorJacobian(const BigInteger& step) const {
+    std::call_once(generator_table_flag_, [this] {
+        const size_t windows_count = N.GetLittleEndianBytes().size() * 8 / kGeneratorWindowBits;
+        std::vector<JacobianPoint> table;
+        table.reserve(windows_count * kGeneratorWindowSize);
+
+        JacobianPoint window_base = JacobianPoint::FromAffine(G);
+        for (size_t i = 0; i < windows_count; ++i) {
+            JacobianPoint multiple = window_base;
+            for (int j = 1; j <= kGeneratorWindowSize; ++j) {
+                table.push_back(multiple);
+                multiple = multiple + window_base;
+            }
+            window_base = multiple;
+        }
+        generator_table_ = JacobianPoint::ToAffineBatch(table);
+    });
+
+    const std::string bytes = (step % N).GetLittleEndianBytes();
+    const size_t windows_count = generator_table_.size() / kGeneratorWindowSize;
+    JacobianPoint res = JacobianPoint::Infinity(*this);
+    // Every entry of the row is read and one addition is made per window; a zero window adds
+    // the first entry and drops the sum. As in the ladder, only which slot is written and kept
+    // depends on the window.
+    Point row_entries[2] = {O, O};
+    for (size_t i = 0; i < windows_count; ++i) {
+        const size_t byte = i * kGeneratorWindowBits / 8;
+        const int window = byte < bytes.size()
+                           ? (static_cast<unsigned char>(bytes[byte]) >> (i * kGeneratorWindowBits % 8))
+                             & kGeneratorWindowSize
+                           : 0;
+        const int index = window - (window != 0);
+        for (int j = 0; j < kGeneratorWindowSize; ++j) {
+            row_entries[j == index] = generator_table_[i * kGeneratorWindowSize + j];
+        }
+        const JacobianPoint sums[2] = {res, res + row_entries[1]};
+        res = sums[window != 0];
+    }
+    return res;
+}
+
+Point::Point(BigInteger x, BigInteger y, const CurveParams& curve)
+        : x(std::move(x)),
+          y(std::move(y)),
+          curve(&curve) {
+}
 
 bool Point::operator == (const Point& rhs) const {
     return (x == rhs.x) && (y == rhs.y);
@@ -71,52 +275,249 @@ bool Point::operator != (const Point& r) const {
     return !(*this == r);
 }
 
+bool Point::isInfinity() const {
+    return x == -1 && y == -1;
+}
+
 Point Point::operator + (const Point& rhs) const {
-    if (*this == O) {
+    if (isInfinity()) {
         return rhs;
     }
-    if (rhs == O) {
+    if (rhs.isInfinity()) {
         return *this;
     }
+    return (JacobianPoint::FromAffine(*this) + rhs).toAffine();
+}
+
+Point Point::operator * (const BigInteger& step) const {
+    return JacobianPoint::Multiply(*this, step).toAffine();
+}
+
+Point Point::multiplyConstantTime(const BigInteger& step) const {
+    return JacobianPoint::MultiplyConstantTime(*this, step).toAffine();
+}
+
+JacobianPoint JacobianPoint::Multiply(const Point& point, const BigInteger& step) {
+    if (step == 0 || point.isInfinity()) {
+        return Infinity(*point.curve);
+    }
+    const JacobianPoint base = FromAffine(point);
 
-    if (*this != rhs && x == rhs.x) {
-        return O;
+    // odd_multiples[i] = (2i + 1) * base, normalized together so that the main loop adds mixed
+    std::vector<JacobianPoint> projective_multiples(1 << (kNafWidth - 2), base);
+    const JacobianPoint doubled = base.twice();
+    for (size_t i = 1; i < projective_multiples.size(); ++i) {
+        projective_multiples[i] = projective_multiples[i - 1] + doubled;
     }
-    if(*this == rhs && y == 0) {
-        return O;
+    const std::vector<Point> odd_multiples = ToAffineBatch(projective_multiples);
+
+    const std::vector<int> naf = getWindowedNaf(getBits(step), kNafWidth);
+    JacobianPoint res = Infinity(*point.curve);
+    for (auto digit = naf.rbegin(); digit != naf.rend(); ++digit) {
+        res = res.twice();
+        if (*digit > 0) {
+            res = res + odd_multiples[*digit / 2];
+        } else if (*digit < 0) {
+            Point negated = odd_multiples[-*digit / 2];
+            if (!negated.isInfinity()) {
+                negated.y = diff(0, negated.y, point.curve->p);
+            }
+            res = res + negated;
+        }
     }
+    return res;
+}
 
-    BigInteger a;
-    BigInteger b;
-    if (*this != rhs) {
-        a = div(diff(rhs.y, y, p), diff(rhs.x, x, p), p);
-        b = div(diff(mult(y, rhs.x, p),
-                     mult(rhs.y, x, p), p),
-                diff(rhs.x, x, p), p);
-    } else {
-        a = div(sum(mult(3, mult(x, x, p), p), A, p),
-                sum(y, y, p), p);
-        b = div(sum(sum(mod(mult(mult(x, x, p), x, p) * -1, p),
-                        mult(A, x, p), p),
-                    mult(2, B, p), p),
-                sum(y, y, p), p);
+JacobianPoint JacobianPoint::MultiplyConstantTime(const Point& point, const BigInteger& step) {
+    const CurveParams& curve = *point.curve;
+    if (point.isInfinity()) {
+        return Infinity(curve);
     }
+    const std::vector<unsigned char> order_bits = getBits(curve.N);
+    std::vector<unsigned char> bits = getBits(step % curve.N);
+    bits.resize(order_bits.size(), 0);
 
-    return Point{diff(diff(mult(a, a, p), x, p), rhs.x, p), diff(sum(mod(BigInteger::pow(a, 3, p) * -1, p), mult(a, sum(x, rhs.x, p), p), p), b, p)};
+    // Invariant: ladder[1] - ladder[0] == point
+    JacobianPoint ladder[2] = {Infinity(curve), FromAffine(point)};
+    for (auto bit = bits.rbegin(); bit != bits.rend(); ++bit) {
+        ladder[1 - *bit] = ladder[0] + ladder[1];
+        ladder[*bit] = ladder[*bit].twice();
+    }
+    return ladder[0];
 }
 
-Point Point::operator * (const BigInteger& step) const {
-    if (step == 0) {
-        return O;
+JacobianPoint::JacobianPoint(BigInteger x, BigInteger y, BigInteger z, const CurveParams& curve)
+        : x(std::move(x)),
+          y(std::move(y)),
+          z(std::move(z)),
+          curve(&curve) {
+}
+
+JacobianPoint JacobianPoint::FromAffine(const Point& point) {
+    const CurveParams& curve = *point.curve;
+    if (point.isInfinity()) {
+        return Infinity(curve);
+    }
+    return JacobianPoint(curve.field.toMontgomery(mod(point.x, curve.p)),
+                         curve.field.toMontgomery(mod(point.y, curve.p)),
+                         curve.montgomery_one, curve);
+}
+
+JacobianPoint JacobianPoint::Infinity(const CurveParams& curve) {
+    return JacobianPoint(curve.montgomery_one, curve.montgomery_one, 0, curve);
+}
+
+Point JacobianPoint::toAffine() const {
+    if (isInfinity()) {
+        return curve->O;
     }
-    Point res;
-    if ((step % 2) == BigInteger::zero()) {
-        res = (*this) * (step / 2);
-        res = res + res;
+    const MontgomeryContext& field = curve->field;
+    if (z == curve->montgomery_one) {
+        return Point(field.fromMontgomery(x), field.fromMontgomery(y), *curve);
+    }
+    BigInteger z_inverse = field.toMontgomery(inverseMod(field.fromMontgomery(z), curve->p));
+    BigInteger z_inverse_square = field.multiply(z_inverse, z_inverse);
+    return Point(field.fromMontgomery(field.multiply(x, z_inverse_square)),
+                 field.fromMontgomery(field.multiply(y, field.multiply(z_inverse_square, z_inverse))),
+                 *curve);
+}
+
+std::vector<Point> JacobianPoint::ToAffineBatch(std::span<const JacobianPoint> points) {
+    if (points.empty()) {
+        return {};
+    }
+    const CurveParams& curve = *points.front().curve;
+    const MontgomeryContext& field = curve.field;
+    std::vector<Point> result(points.size(), curve.O);
+
+    // prefix[i] = product of the non-zero z among points[0..i]
+    std::vector<BigInteger> prefix(points.size());
+    BigInteger product = curve.montgomery_one;
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (!points[i].isInfinity()) {
+            product = field.multiply(product, points[i].z);
+        }
+        prefix[i] = product;
+    }
+
+    // inverse = 1 / prefix[i] while walking back; 1 / z_i = inverse * prefix[i - 1]
+    BigInteger inverse = field.toMontgomery(inverseMod(field.fromMontgomery(product), curve.p));
+    for (size_t i = points.size(); i-- > 0; ) {
+        const JacobianPoint& point = points[i];
+        if (point.isInfinity()) {
+            continue;
+        }
+        BigInteger z_inverse = i > 0 ? field.multiply(inverse, prefix[i - 1]) : inverse;
+        inverse = field.multiply(inverse, point.z);
+
+        BigInteger z_inverse_square = field.multiply(z_inverse, z_inverse);
+        result[i] = Point(field.fromMontgomery(field.multiply(point.x, z_inverse_square)),
+                          field.fromMontgomery(field.multiply(point.y,
+                                                              field.multiply(z_inverse_square, z_inverse))),
+                          curve);
+    }
+    return result;
+}
+
+JacobianPoint JacobianPoint::negate() const {
+    return JacobianPoint(x, diff(0, y, curve->p), z, *curve);
+}
+
+bool JacobianPoint::isInfinity() const {
+    return z == 0;
+}
+
+JacobianPoint JacobianPoint::twice() const {
+    if (isInfinity() || y == 0) {
+        return Infinity(*curve);
+    }
+    const MontgomeryContext& field = curve->field;
+    const BigInteger& p = curve->p;
+
+    BigInteger y_square = field.multiply(y, y);
+    BigInteger z_square = field.multiply(z, z);
+    BigInteger s = field.multiply(x, y_square);
+    s = sum(s, s, p);
+    s = sum(s, s, p);
+    BigInteger m;
+    if (curve->a_is_minus_three) {
+        // 3x^2 - 3z^4 = 3 (x - z^2) (x + z^2)
+        m = field.multiply(diff(x, z_square, p), sum(x, z_square, p));
     } else {
-        res = ((*this) * (step - 1)) + (*this);
+        m = field.multiply(x, x);
     }
-    return res;
+    m = sum(sum(m, m, p), m, p);
+    if (!curve->a_is_minus_three) {
+        m = sum(m, field.multiply(curve->montgomery_a, field.multiply(z_square, z_square)), p);
+    }
+    BigInteger y_fourth_times_8 = field.multiply(y_square, y_square);
+    for (int i = 0; i < 3; ++i) {
+        y_fourth_times_8 = sum(y_fourth_times_8, y_fourth_times_8, p);
+    }
+
+    BigInteger res_x = diff(field.multiply(m, m), sum(s, s, p), p);
+    BigInteger res_y = diff(field.multiply(m, diff(s, res_x, p)), y_fourth_times_8, p);
+    return JacobianPoint(std::move(res_x), std::move(res_y), field.multiply(sum(y, y, p), z), *curve);
+}
+
+JacobianPoint JacobianPoint::operator + (const JacobianPoint& rhs) const {
+    if (isInfinity()) {
+        return rhs;
+    }
+    if (rhs.isInfinity()) {
+        return *this;
+    }
+    const MontgomeryContext& field = curve->field;
+    const BigInteger& p = curve->p;
+
+    BigInteger z1_square = field.multiply(z, z);
+    BigInteger z2_square = field.multiply(rhs.z, rhs.z);
+    BigInteger u1 = field.multiply(x, z2_square);
+    BigInteger u2 = field.multiply(rhs.x, z1_square);
+    BigInteger s1 = field.multiply(y, field.multiply(z2_square, rhs.z));
+    BigInteger s2 = field.multiply(rhs.y, field.multiply(z1_square, z));
+    BigInteger h = diff(u2, u1, p);
+    BigInteger r = diff(s2, s1, p);
+    if (h == 0) {
+        return r == 0 ? twice() : Infinity(*curve);
+    }
+
+    BigInteger h_square = field.multiply(h, h);
+    BigInteger h_cube = field.multiply(h_square, h);
+    BigInteger v = field.multiply(u1, h_square);
+
+    BigInteger res_x = diff(diff(field.multiply(r, r), h_cube, p), sum(v, v, p), p);
+    BigInteger res_y = diff(field.multiply(r, diff(v, res_x, p)), field.multiply(s1, h_cube), p);
+    return JacobianPoint(std::move(res_x), std::move(res_y), field.multiply(field.multiply(z, rhs.z), h), *curve);
+}
+
+JacobianPoint JacobianPoint::operator + (const Point& rhs) const {
+    if (rhs.isInfinity()) {
+        return *this;
+    }
+    if (isInfinity()) {
+        return FromAffine(rhs);
+    }
+    const MontgomeryContext& field = curve->field;
+    const BigInteger& p = curve->p;
+
+    // Affine points are stored outside Montgomery form
+    BigInteger z_square = field.multiply(z, z);
+    BigInteger u2 = field.multiply(field.toMontgomery(rhs.x), z_square);
+    BigInteger s2 = field.multiply(field.toMontgomery(rhs.y), field.multiply(z_square, z));
+    BigInteger h = diff(u2, x, p);
+    BigInteger r = diff(s2, y, p);
+    if (h == 0) {
+        return r == 0 ? twice() : Infinity(*curve);
+    }
+
+    BigInteger h_square = field.multiply(h, h);
+    BigInteger h_cube = field.multiply(h_square, h);
+    BigInteger v = field.multiply(x, h_square);
+
+    BigInteger res_x = diff(diff(field.multiply(r, r), h_cube, p), sum(v, v, p), p);
+    BigInteger res_y = diff(field.multiply(r, diff(v, res_x, p)), field.multiply(y, h_cube), p);
+    return JacobianPoint(std::move(res_x), std::move(res_y), field.multiply(z, h), *curve);
 }
 
 std::ostream& operator << (std::ostream& os, const Point& a) {
@@ -124,61 +525,100 @@ std::ostream& operator << (std::ostream& os, const Point& a) {
     return os;
 }
 
-static BigInteger parseHexadecimal(const std::string& hex) {
-    const auto l = hex.size();
-    BigInteger res = 0;
-    for (auto i = 0; i < l; ++i) {
-        res *= 16;
-        if ('0' <= hex[i] && hex[i] <= '9') {
-            res += hex[i] - '0';
-        }
-        else if ('A' <= hex[i] && hex[i] <= 'F') {
-            res += (hex[i] - 'A') + 10;
-        }
-        else if ('a' <= hex[i] && hex[i] <= 'z') {
-            res += (hex[i] - 'a') + 10;
-        }
-        else {
-            printf("Wrong letter %c in hexadecimal format\n", hex[i]);
-            exit(1);
+namespace {
+    /// Bob's private k and the ephemeral r of encode.
+    BigInteger GetRandomScalar(const CurveParams& curve) {
+//        BigInteger r = Crypto::GetRandomNumber(1, curve.N - 1);
+        BigInteger r = 0;
+        while (r == 0) {
+            r = Crypto::GetRandomNumber(1, 99) % curve.N;
         }
+        return r;
     }
-    return res;
-}
+}  // namespace
 
-Bob::Bob() {
-//    k = Crypto::GetRandomNumber(1, N - 1);
-    k = 0;
-    while (k == 0) {
-        k = Crypto::GetRandomNumber(1, 99) % N;
-    }
-    Y = G * k;
+Bob::Bob(const CurveParams& curve)
+        : k(GetRandomScalar(curve)),
+          Y(curve.multiplyGenerator(k)) {
 }
 
 Point Bob::decode(const std::pair<Point, Point>& code) {
-    Point s = code.first * k;
-    s.y *= -1;
-    return s+code.second;
+    Point s = code.first.multiplyConstantTime(k);
+    if (!s.isInfinity()) {
+        s.y = diff(0, s.y, s.curve->p);
+    }
+    return s + code.second;
 }
 
 std::pair<Point, Point> encode(const Point& M, const Point& key) {
-//    BigInteger r = Crypto::GetRandomNumber(1, N - 1);
-    BigInteger r = 0;
-    while (r == 0) {
-        r = Crypto::GetRandomNumber(1, 99) % N;
-    }
-    Point d = key * r;
-    Point g = G * r;
+    const CurveParams& curve = *key.curve;
+    BigInteger r = GetRandomScalar(curve);
+    Point d = key.multiplyConstantTime(r);
+    Point g = curve.multiplyGenerator(r);
     Point h = M + d;
     return std::make_pair(g, h);
 }
 
+std::vector<std::pair<Point, Point>> encodeBatch(std::span<const Point> messages, const Point& key,
+                                                 size_t threads_count) {
+    const CurveParams& curve = *key.curve;
+    if (threads_count == 0) {
+        threads_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads_count = std::max<size_t>(1, std::min(threads_count, messages.size()));
+
+    // rand() isn't meant to be shared between threads, so all r are drawn up front
+    std::vector<BigInteger> ephemeral_keys;
+    ephemeral_keys.reserve(messages.size());
+    for (size_t i = 0; i < messages.size(); ++i) {
+        ephemeral_keys.push_back(GetRandomScalar(curve));
+    }
+
+    std::vector<std::pair<Point, Point>> result(messages.size(), std::make_pair(curve.O, curve.O));
+    auto encode_range = [&](size_t begin, size_t end) {
+        // (g_i, h_i) interleaved, projective until the single normalization below
+        std::vector<JacobianPoint> projective;
+        projective.reserve(2 * (end - begin));
+        for (size_t i = begin; i < end; ++i) {
+            DigitArena::Scope arena_scope;
+            JacobianPoint g = curve.multiplyGeneratorJacobian(ephemeral_keys[i]);
+            JacobianPoint h = JacobianPoint::MultiplyConstantTime(key, ephemeral_keys[i]) + messages[i];
+
+            DigitResourceScope heap_scope(nullptr);
+            projective.push_back(g);
+            projective.push_back(h);
+        }
+
+        const std::vector<Point> affine = JacobianPoint::ToAffineBatch(projective);
+        for (size_t i = begin; i < end; ++i) {
+            result[i] = std::make_pair(affine[2 * (i - begin)], affine[2 * (i - begin) + 1]);
+        }
+    };
+
+    if (threads_count <= 1) {
+        encode_range(0, messages.size());
+        return result;
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(threads_count);
+    for (size_t thread = 0; thread < threads_count; ++thread) {
+        threads.emplace_back(encode_range, messages.size() * thread / threads_count,
+                             messages.size() * (thread + 1) / threads_count);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return result;
+}
+
 void Emulate() {
+    const CurveParams& curve = CurveParams::Secp112r1();
     std :: cout << "El-Gamal\n";
     std :: cout << "Point to encode: ";
-    Point M = G * 10;
+    Point M = curve.G * 10;
     std :: cout << M << '\n';
-    Bob b;
+    Bob b(curve);
     std :: cout << "Key: ";
     std :: cout << b.Y << '\n';
     std::pair<Point, Point> code = encode(M, b.Y);
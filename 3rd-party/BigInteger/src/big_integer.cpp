@@ -1,15 +1,18 @@
 #include "big_integer.h"
+#include "tracing.h"
 
 #include <utility>
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <optional>
 
 // TODO: Use static_cast<> instead of C-style casts
 
 namespace {
 // True if lhs < rhs
-    bool CompareTwoDigitalVectors(const std::vector<BigInteger::Digit>& lhs,
-                                  const std::vector<BigInteger::Digit>& rhs) {
+    bool CompareTwoDigitalVectors(const BigInteger::Digits& lhs,
+                                  const BigInteger::Digits& rhs) {
         if (lhs.size() < rhs.size()) return true;
         for (auto i = lhs.size(); i > 0; --i) {
             if (lhs[i - 1] != rhs[i - 1]) {
@@ -69,6 +72,7 @@ namespace {
 }  // namespace
 
 BigInteger::BigInteger(long long number) {
+    FS_COUNT(BIGINT_ALLOCATIONS);
     if (number < 0) {
         number *= -1;
         is_positive_ = false;
@@ -86,6 +90,7 @@ BigInteger::BigInteger(long long number) {
 }
 
 BigInteger::BigInteger(const BigInteger& other) {
+    FS_COUNT(BIGINT_ALLOCATIONS);
     num_ = other.num_;
     is_positive_ = other.is_positive_;
 }
@@ -96,6 +101,7 @@ BigInteger::BigInteger(BigInteger&& other) noexcept {
 }
 
 BigInteger::BigInteger(const std::string& number) {
+    FS_COUNT(BIGINT_ALLOCATIONS);
     std::string tmp = number;
     if (!tmp.empty() && tmp[0] == '-') {
         is_positive_ = false;
@@ -103,7 +109,7 @@ BigInteger::BigInteger(const std::string& number) {
     }
     assert(tmp.size() > 0);
     
-    std::vector<Digit> digits;
+    Digits digits;
     digits.reserve(tmp.size());
     std::reverse(tmp.begin(), tmp.end());
     for (int i = 0; i < tmp.size(); ++i) {
@@ -117,7 +123,7 @@ BigInteger::BigInteger(const std::string& number) {
     validate();
 }
 
-BigInteger BigInteger::buildByDigitalVector(const std::vector<Digit>& number) {
+BigInteger BigInteger::buildByDigitalVector(const Digits& number) {
     if (number.empty()) return BigInteger(0);
     return BigInteger(number);
 }
@@ -127,7 +133,7 @@ BigInteger BigInteger::zero() {
     return result;
 }
 
-const std::vector<BigInteger::Digit>& BigInteger::data() const {
+const BigInteger::Digits& BigInteger::data() const {
     return num_;
 }
 
@@ -139,6 +145,20 @@ size_t BigInteger::getLength() const {
     return num_.size();
 }
 
+BigInteger BigInteger::getLowDigits(size_t count) const {
+    if (count >= num_.size()) {
+        return abs(*this);
+    }
+    return buildByDigitalVector(Digits(num_.begin(), num_.begin() + count));
+}
+
+BigInteger BigInteger::dropLowDigits(size_t count) const {
+    if (count >= num_.size()) {
+        return zero();
+    }
+    return buildByDigitalVector(Digits(num_.begin() + count, num_.end()));
+}
+
 bool BigInteger::IsEven() const {
     return !(num_[0] & 1);
 }
@@ -232,6 +252,9 @@ BigInteger& BigInteger::operator = (long long other) {
 }
 
 BigInteger& BigInteger::operator = (const BigInteger& other) {
+    if (num_.capacity() < other.num_.size()) {
+        FS_COUNT(BIGINT_ALLOCATIONS);
+    }
     num_ = other.num_;
     is_positive_ = other.is_positive_;
     return *this;
@@ -306,6 +329,7 @@ BigInteger BigInteger::operator * (long long other) const {
 }
 
 BigInteger BigInteger::operator * (const BigInteger& other) const {
+    FS_COUNT_MULTIPLICATION(std::max(getLength(), other.getLength()));
     return KaratsubaMultiplication(*this, other);
 }
 
@@ -391,16 +415,132 @@ BigInteger BigInteger::pow(const BigInteger& number, const BigInteger& power) {
 
 BigInteger BigInteger::pow(const BigInteger& number, const BigInteger& power,
                           const BigInteger& module) {
+    FS_TRACE_SPAN("BigInteger::pow");
+    FS_COUNT(MODULAR_EXPONENTIATIONS);
+    return ModularPow(number, power, module);
+}
+
+BigInteger BigInteger::ModularPow(const BigInteger& number, const BigInteger& power,
+                                  const BigInteger& module) {
     if (power == zero()) {
         return mod(BigInteger(1), module);
     }
     if (power.getDigitAt(power.getLength()) & 1) {
-        return mod(pow(number, power - 1, module) * number, module);
+        return mod(ModularPow(number, power - 1, module) * number, module);
     }
-    BigInteger w = pow(number, power / 2, module);
+    BigInteger w = ModularPow(number, power / 2, module);
     return mod(w * w, module);
 }
 
+BigInteger BigInteger::multiPow(const std::vector<BigInteger>& bases,
+                                const std::vector<BigInteger>& exponents,
+                                const BigInteger& module) {
+    FS_TRACE_SPAN("BigInteger::multiPow");
+    FS_COUNT(MODULAR_EXPONENTIATIONS);
+    assert(bases.size() == exponents.size());
+    assert(module.IsPositive() && module != zero());
+
+    size_t max_length = 0;
+    for (const auto& exponent : exponents) {
+        assert(exponent.IsPositive());
+        max_length = std::max(max_length, exponent.getLength());
+    }
+
+    /// Windows are single decimal digits of the exponents.
+    /// Straus pays 8 multiplications per base for its tables,
+    /// Pippenger pays up to 18 multiplications per digit position for its buckets.
+    if (18 * max_length < 8 * bases.size()) {
+        return PippengerMultiPow(bases, exponents, module, max_length);
+    }
+    return StrausMultiPow(bases, exponents, module, max_length);
+}
+
+namespace {
+    BigInteger PowerOfTenMod(const BigInteger& number, const BigInteger& module) {
+        /// x^10 = ((x^2)^2 * x)^2
+        BigInteger square = (number * number) % module;
+        BigInteger fifth = (((square * square) % module) * number) % module;
+        return (fifth * fifth) % module;
+    }
+}  // namespace
+
+BigInteger BigInteger::StrausMultiPow(const std::vector<BigInteger>& bases,
+                                      const std::vector<BigInteger>& exponents,
+                                      const BigInteger& module, size_t max_length) {
+    /// table[i][d] = bases[i] ^ d, 1 <= d <= 9
+    std::vector<std::vector<BigInteger>> table(bases.size());
+    for (size_t i = 0; i < bases.size(); ++i) {
+        table[i].reserve(10);
+        table[i].emplace_back(1);
+        table[i].push_back(mod(bases[i], module));
+        for (int d = 2; d < 10; ++d) {
+            table[i].push_back((table[i].back() * table[i][1]) % module);
+        }
+    }
+
+    BigInteger result = mod(BigInteger(1), module);
+    for (size_t pos = max_length; pos > 0; --pos) {
+        if (pos != max_length) {
+            result = PowerOfTenMod(result, module);
+        }
+        for (size_t i = 0; i < bases.size(); ++i) {
+            const auto& digits = exponents[i].num_;
+            if (pos <= digits.size() && digits[pos - 1] != 0) {
+                result = (result * table[i][digits[pos - 1]]) % module;
+            }
+        }
+    }
+    return result;
+}
+
+BigInteger BigInteger::PippengerMultiPow(const std::vector<BigInteger>& bases,
+                                         const std::vector<BigInteger>& exponents,
+                                         const BigInteger& module, size_t max_length) {
+    std::vector<BigInteger> reduced_bases;
+    reduced_bases.reserve(bases.size());
+    for (const auto& base : bases) {
+        reduced_bases.push_back(mod(base, module));
+    }
+
+    BigInteger result = mod(BigInteger(1), module);
+    std::vector<BigInteger> buckets(10);
+    std::vector<bool> is_bucket_used(10);
+    for (size_t pos = max_length; pos > 0; --pos) {
+        if (pos != max_length) {
+            result = PowerOfTenMod(result, module);
+        }
+
+        std::fill(is_bucket_used.begin(), is_bucket_used.end(), false);
+        for (size_t i = 0; i < reduced_bases.size(); ++i) {
+            const auto& digits = exponents[i].num_;
+            if (pos > digits.size() || digits[pos - 1] == 0) {
+                continue;
+            }
+            const Digit d = digits[pos - 1];
+            if (is_bucket_used[d]) {
+                buckets[d] = (buckets[d] * reduced_bases[i]) % module;
+            } else {
+                buckets[d] = reduced_bases[i];
+                is_bucket_used[d] = true;
+            }
+        }
+
+        /// prod(buckets[d] ^ d) as a product of suffix products
+        std::optional<BigInteger> running, total;
+        for (int d = 9; d > 0; --d) {
+            if (is_bucket_used[d]) {
+                running = running ? (*running * buckets[d]) % module : buckets[d];
+            }
+            if (running) {
+                total = total ? (*total * *running) % module : *running;
+            }
+        }
+        if (total) {
+            result = (result * *total) % module;
+        }
+    }
+    return result;
+}
 
 void BigInteger::validateSign() {
     if (num_.size() == 1 && num_.at(0) == 0) {
@@ -416,8 +556,8 @@ void BigInteger::validate() {
 }
 
 BigInteger::CompareSign BigInteger::compareUnsignedNumbers(
-        const std::vector<BigInteger::Digit>& lhs,
-        const std::vector<BigInteger::Digit>& rhs) {
+        const BigInteger::Digits& lhs,
+        const BigInteger::Digits& rhs) {
     if (lhs.size() != rhs.size()) {
         return (lhs.size() < rhs.size() ? CompareSign::LESS
                                         : CompareSign::GREATER);
@@ -431,10 +571,10 @@ BigInteger::CompareSign BigInteger::compareUnsignedNumbers(
     return CompareSign::EQUAL;
 }
 
-std::vector<BigInteger::Digit> BigInteger::getUnsignedSum(const std::vector<Digit>& lhs,
-                                              const std::vector<Digit>& rhs) {
+BigInteger::Digits BigInteger::getUnsignedSum(const Digits& lhs,
+                                              const Digits& rhs) {
     auto max_length = std::max(lhs.size(), rhs.size());
-    std::vector<Digit> sum(max_length + 1, 0);
+    Digits sum(max_length + 1, 0);
 
     long long d = 0;
     for (long long i = 0; i < max_length; ++i) {
@@ -448,13 +588,13 @@ std::vector<BigInteger::Digit> BigInteger::getUnsignedSum(const std::vector<Digi
     return sum;
 }
 
-std::vector<BigInteger::Digit> BigInteger::getUnsignedDiff(const std::vector<Digit>& lhs,
-                                               const std::vector<Digit>& rhs) {
+BigInteger::Digits BigInteger::getUnsignedDiff(const Digits& lhs,
+                                               const Digits& rhs) {
     if (lhs.size() < rhs.size()) {
         exit(1);
     }
 
-    std::vector<Digit> diff(lhs.size(), 0);
+    Digits diff(lhs.size(), 0);
     long long d = 0;
     for (long long i = 0; i < lhs.size(); ++i) {
         long long c = (lhs[i] - d - (i < rhs.size() ? rhs[i] : 0));
@@ -475,6 +615,7 @@ std::vector<BigInteger::Digit> BigInteger::getUnsignedDiff(const std::vector<Dig
 
 BigInteger::DivisionResult BigInteger::getUnsignedDivision(BigInteger lhs,
                                                            BigInteger rhs) {
+    FS_COUNT(DIVISIONS);
     BigInteger::DivisionResult result;
 
     if (lhs.num_.size() < rhs.num_.size()) {
@@ -487,11 +628,11 @@ BigInteger::DivisionResult BigInteger::getUnsignedDivision(BigInteger lhs,
     rhs.is_positive_ = true;
     const long long kLen((long long)rhs.num_.size());
 
-    std::vector<Digit> quotient((long long)lhs.num_.size() - kLen + 1, 0);
+    Digits quotient((long long)lhs.num_.size() - kLen + 1, 0);
     while (rhs <= lhs) {
         long long cur_len = kLen;
 
-        std::vector<Digit> prefix;
+        Digits prefix;
         prefix.reserve(cur_len);
         for (long long i = cur_len; i > 0; --i) {
             prefix.push_back(lhs.num_[(long long)lhs.num_.size() - i]);
@@ -524,7 +665,7 @@ BigInteger::DivisionResult BigInteger::getUnsignedDivision(BigInteger lhs,
 
 BigInteger BigInteger::NativeMultiplication(const BigInteger& lhs, const BigInteger& rhs) {
     // TODO: Optimize multiplication on small numbers
-    std::vector<Digit> mult(lhs.num_.size() + rhs.num_.size(), 0);
+    Digits mult(lhs.num_.size() + rhs.num_.size(), 0);
     for (long long i = 0; i < lhs.num_.size(); ++i) {
         for (long long j = 0, d = 0; j < rhs.num_.size() || d != 0; ++j) {
             long long cur = (long long)lhs.num_[i] * (long long)(j < rhs.num_.size() ? rhs.num_[j] : 0)
@@ -545,7 +686,7 @@ BigInteger BigInteger::KaratsubaMultiplication(const BigInteger& lhs, const BigI
         return BigInteger::zero();
     }
 
-    if (std::min(lhs.getLength(), rhs.getLength()) <= 100) {
+    if (std::min(lhs.getLength(), rhs.getLength()) <= kKaratsubaThreshold) {
         return NativeMultiplication(lhs, rhs);
     }
 
@@ -565,14 +706,14 @@ BigInteger BigInteger::KaratsubaMultiplication(const BigInteger& lhs, const BigI
             return result;
         }
 
-        std::vector<Digit> rhs_part;
+        Digits rhs_part;
         rhs_part.reserve(rhs_len);
         for (int i = 0; i < rhs_len; ++i) {
             rhs_part.push_back(number.num_[i]);
         }
         result.rhs = BigInteger(rhs_part);
 
-        std::vector<Digit> lhs_part;
+        Digits lhs_part;
         lhs_part.reserve(len - rhs_len);
         for (int i = rhs_len; i < len; ++i) {
             lhs_part.push_back(number.num_[i]);
@@ -609,7 +750,7 @@ BigInteger BigInteger::KaratsubaMultiplication(const BigInteger& lhs, const BigI
                               C1.getLength() + 2 * base_length);
     std::vector<int> result(result_len, 0);
 
-    auto AddTo = [](std::vector<int>& result, std::vector<Digit>& number, int starting_pos) {
+    auto AddTo = [](std::vector<int>& result, Digits& number, int starting_pos) {
         assert(result.size() >= number.size() + starting_pos);
         for (int i = 0; i < number.size(); ++i) {
             result[starting_pos + i] += static_cast<int>(number[i]);
@@ -619,7 +760,7 @@ BigInteger BigInteger::KaratsubaMultiplication(const BigInteger& lhs, const BigI
     AddTo(result, C2.num_, base_length);
     AddTo(result, C1.num_, 2 * base_length);
 
-    std::vector<Digit> byte_result;
+    Digits byte_result;
     byte_result.reserve(result.size());
     int d = 0;
     for (int i = 0; i < result.size() || d; ++i) {
@@ -654,7 +795,7 @@ BigInteger BigInteger::sqrt(const BigInteger& number) {
         return number;
     }
     long long len = ((long long)number.num_.size() + 1) / 2;
-    std::vector<Digit> result(len, 0);
+    Digits result(len, 0);
     for (long long i = len - 1; i >= 0; --i) {
         Digit l = 0;
         Digit r = 9;
@@ -798,21 +939,46 @@ std::string BigInteger::GetBase64() const {
 }
 
 std::string BigInteger::GetByte() const {
-    BigInteger tmp = *this;
-    if (!tmp.IsPositive()) {
-        tmp.is_positive_ = true;
+    std::string result = GetLittleEndianBytes();
+    std::reverse(result.begin(), result.end());
+
+    if (result.empty()) {
+        result += static_cast<unsigned char>(0);
+    }
+    return result;
+}
+
+std::string BigInteger::GetLittleEndianBytes() const {
+    // Short division of the decimal digits by 2^56, seven bytes per pass:
+    // rest * 10 + digit < 10 * 2^56 fits into 64 bits.
+    constexpr int kGroupBits = 56;
+    constexpr uint64_t kGroupMask = (uint64_t{1} << kGroupBits) - 1;
+
+    Digits digits(num_.rbegin(), num_.rend());
+    size_t begin = 0;
+    while (begin < digits.size() && digits[begin] == 0) {
+        ++begin;
     }
 
     std::string result;
-    while (tmp > 0) {
-        auto r = tmp % 256;
-        result += static_cast<unsigned char>(r.ToInt());
-        tmp /= 256;
+    result.reserve(num_.size() * 5 / 12 + 8);
+    while (begin < digits.size()) {
+        uint64_t rest = 0;
+        for (size_t i = begin; i < digits.size(); ++i) {
+            uint64_t current = rest * 10 + digits[i];
+            digits[i] = static_cast<Digit>(current >> kGroupBits);
+            rest = current & kGroupMask;
+        }
+        for (int byte = 0; byte < kGroupBits / 8; ++byte, rest >>= 8) {
+            result += static_cast<char>(rest & 0xff);
+        }
+        while (begin < digits.size() && digits[begin] == 0) {
+            ++begin;
+        }
     }
-    std::reverse(result.begin(), result.end());
 
-    if (result.empty()) {
-        result += static_cast<unsigned char>(0);
+    while (!result.empty() && result.back() == 0) {
+        result.pop_back();
     }
     return result;
 }
@@ -836,10 +1002,62 @@ BigInteger BigInteger::GetFromBase64(const std::string& src) {
 }
 
 BigInteger BigInteger::GetFromByte(const std::string& src) {
-    BigInteger result = 0;
-    for (unsigned char c : src) {
-        result *= 256;
-        result += static_cast<int>(c);
+    std::string bytes(src.rbegin(), src.rend());
+    return GetFromLittleEndianBytes(reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size());
+}
+
+BigInteger BigInteger::GetFromLittleEndianBytes(const unsigned char* src, size_t size) {
+    // Horner's scheme over groups of up to 7 bytes from the most significant end,
+    // multiply-add in place: digit * 2^56 + carry < 10 * 2^56 fits into 64 bits.
+    constexpr size_t kGroupBytes = 7;
+
+    Digits digits;
+    digits.reserve(size * 241 / 100 + 20);
+    size_t position = size;
+    while (position > 0) {
+        size_t group = (position - 1) % kGroupBytes + 1;
+        position -= group;
+
+        uint64_t carry = 0;
+        for (size_t i = group; i > 0; --i) {
+            carry = (carry << 8) | src[position + i - 1];
+        }
+        const uint64_t multiplier = uint64_t{1} << (8 * group);
+        for (auto& digit : digits) {
+            uint64_t current = digit * multiplier + carry;
+            digit = static_cast<Digit>(current % 10);
+            carry = current / 10;
+        }
+        for (; carry != 0; carry /= 10) {
+            digits.push_back(static_cast<Digit>(carry % 10));
+        }
+    }
+
+    return buildByDigitalVector(digits);
+}
+
+
+size_t BigInteger::GetPackedDigitsSize() const {
+    return (num_.size() + 1) / 2;
+}
+
+void BigInteger::WritePackedDigits(unsigned char* dst, size_t width) const {
+    assert(width >= GetPackedDigitsSize());
+    for (size_t i = 0; i < width; ++i) {
+        const Digit low = (2 * i < num_.size() ? num_[2 * i] : 0);
+        const Digit high = (2 * i + 1 < num_.size() ? num_[2 * i + 1] : 0);
+        dst[i] = static_cast<unsigned char>(low | (high << 4));
     }
-    return result;
 }
+
+std::optional<BigInteger> BigInteger::GetFromPackedDigits(const unsigned char* src, size_t width) {
+    Digits digits(2 * width);
+    for (size_t i = 0; i < width; ++i) {
+        digits[2 * i] = src[i] & 0x0F;
+        digits[2 * i + 1] = src[i] >> 4;
+        if (digits[2 * i] > 9 || digits[2 * i + 1] > 9) {
+            return std::nullopt;
+        }
+    }
+    return buildByDigitalVector(digits);
+}
\ No newline at end of file
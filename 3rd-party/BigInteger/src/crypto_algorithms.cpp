@@ -1,11 +1,20 @@
 #include <map>
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
+#include <mutex>
+#include <optional>
 #include <random>
+#include <string>
+#include <thread>
+#include <cerrno>
+#include <sys/random.h>
 #include <sys/time.h>
 
 #include "crypto_algorithms.h"
+#include "montgomery.h"
+#include "tracing.h"
 
 namespace {
 
@@ -48,6 +57,189 @@ namespace {
         }
     }
 
+
+    /// Steps of a Brent walk between two gcds: |x - y| products are accumulated meanwhile.
+    constexpr int kBrentBlockSize = 100;
+
+    /// One Brent walk x -> x^2 + c mod n from start. The walk runs in Montgomery form: with X = xR,
+    /// X^2 / R + cR = (x^2 + c) R, and R is coprime with n, so gcds are unaffected.
+    /// Returns a non-trivial divisor, or std::nullopt if the walk collapsed (gcd n even after
+    /// backtracking) or stop was raised by another walk.
+    std::optional<BigInteger> BrentRhoWalk(const MontgomeryContext& context, const BigInteger& start,
+                                           const BigInteger& c, const std::atomic<bool>& stop) {
+        const BigInteger& number = context.getModule();
+        const BigInteger shift = context.toMontgomery(c);
+        auto step = [&](const BigInteger& value) {
+            BigInteger next = context.multiply(value, value) + shift;
+            if (next >= number) {
+                next -= number;
+            }
+            return next;
+        };
+
+        BigInteger y = context.toMontgomery(start);
+        BigInteger x = y;
+        BigInteger saved_y = y;
+        BigInteger product = context.toMontgomery(1);
+        BigInteger g = 1;
+        for (long long length = 1; g == 1; length *= 2) {
+            x = y;
+            for (long long i = 0; i < length; ++i) {
+                y = step(y);
+            }
+            for (long long done = 0; done < length && g == 1; done += kBrentBlockSize) {
+                if (stop.load(std::memory_order_relaxed)) {
+                    return std::nullopt;
+                }
+                saved_y = y;
+                const long long block = std::min<long long>(kBrentBlockSize, length - done);
+                for (long long i = 0; i < block; ++i) {
+                    y = step(y);
+                    product = context.multiply(product, BigInteger::abs(x - y));
+                }
+                g = BigInteger::gcd(product, number);
+            }
+        }
+
+        // The block overshot: redo it one gcd per step
+        if (g == number) {
+            do {
+                saved_y = step(saved_y);
+                g = BigInteger::gcd(BigInteger::abs(x - saved_y), number);
+            } while (g == 1);
+        }
+        if (g == number) {
+            return std::nullopt;
+        }
+        return g;
+    }
+
+    /// Runs walks_count independent walks (one per thread when there are several) and
+    /// returns the first divisor found; the other walks stop at their next gcd.
+    std::optional<BigInteger> FindDivisor(const BigInteger& number, size_t walks_count) {
+        const MontgomeryContext context(number);
+
+        // rand() isn't meant to be shared between threads, so the walks are drawn here
+        std::vector<std::pair<BigInteger, BigInteger>> walks;
+        walks.reserve(walks_count);
+        for (size_t i = 0; i < walks_count; ++i) {
+            BigInteger start = Crypto::GetRandomNumber(number - 1);
+            BigInteger c = Crypto::GetRandomNumber(1, number - 1);
+            walks.emplace_back(start, c);
+        }
+
+        std::atomic<bool> stop{false};
+        if (walks_count == 1) {
+            return BrentRhoWalk(context, walks[0].first, walks[0].second, stop);
+        }
+
+        std::mutex mutex;
+        std::optional<BigInteger> divisor;
+        std::vector<std::thread> threads;
+        threads.reserve(walks_count);
+        for (const auto& walk : walks) {
+            threads.emplace_back([&context, &walk, &stop, &mutex, &divisor] {
+                std::optional<BigInteger> found = BrentRhoWalk(context, walk.first, walk.second, stop);
+                if (found.has_value()) {
+                    std::lock_guard lock(mutex);
+                    if (!divisor.has_value()) {
+                        divisor = std::move(found);
+                        stop.store(true, std::memory_order_relaxed);
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        return divisor;
+    }
+
+    /// Uniform in [0, max_value], one decimal digit at a time; draw_digit(bound) is uniform in [0, bound).
+    template <typename DrawDigit>
+    BigInteger GetRandomNumberImpl(const BigInteger& max_value, const DrawDigit& draw_digit) {
+        const size_t max_length = max_value.getLength();
+
+        BigInteger result = 0;
+        bool is_smaller = false;
+        for (int i = 1; i <= max_length; ++i) {
+            if (is_smaller) {
+                int new_digit = draw_digit(10);
+                result = (result * 10) + new_digit;
+            } else {
+                int cur_digit = max_value.getDigitAt(i);
+                int new_digit = draw_digit(cur_digit + 1);
+
+                result = (result * 10) + new_digit;
+                is_smaller |= (new_digit < cur_digit);
+            }
+        }
+        return result;
+    }
+
+    /// Bases are drawn by draw_base(lhs, rhs), uniform in [lhs, rhs].
+    template <typename DrawBase>
+    bool MillerRabinTestImpl(const BigInteger& number, const DrawBase& draw_base) {
+        if (number == 2 || number == 3) {
+            return true;
+        }
+        if (number < 2 || number % 2 == 0) {
+            return false;
+        }
+
+        int degree = 0;
+        BigInteger d = (number - 1);
+        BigInteger q = d;
+        while (d % 2 == 0) {
+            ++degree;
+            d /= 2;
+        }
+
+        for (int i = 0; i < std::max(10, degree); ++i) {
+            BigInteger alpha = draw_base(BigInteger(2), number - 2);
+            BigInteger x = BigInteger::pow(alpha, d, number);
+            if (x == 1 || x == q) {
+                continue;
+            }
+            for (int j = 1; j < degree; ++j) {
+                x = (x * x) % number;
+                if (x == 1) {
+                    return false;
+                } else if (x == q) {
+                    break;
+                }
+            }
+
+            if (x != q) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// miller_rabin_test is Crypto::MillerRabinTest with some source of bases.
+    template <typename MillerRabin>
+    bool BPSWTestImpl(const BigInteger& number, const MillerRabin& miller_rabin_test) {
+        if (number == 2) {
+            return true;
+        }
+        if (number < 2 || number % 2 == 0) {
+            return  false;
+        }
+        // Plain ints: a static table of BigIntegers could be built inside a thread's digit arena
+        for (int small_prime : {3, 5, 7, 11, 13, 17, 19, 23, 29}) {
+            if (number == small_prime) {
+                return true;
+            }
+            if (number % small_prime == 0) {
+                return false;
+            }
+        }
+        if (!miller_rabin_test(number)) {
+            return false;
+        }
+        return Crypto::LucasSelfridgeTest(number);
+    }
 }  // namespace
 
 void Crypto::RandomSeedInitialization() {
@@ -59,23 +251,7 @@ void Crypto::RandomSeedInitialization() {
 }
 
 BigInteger Crypto::GetRandomNumber(const BigInteger& max_value) {
-    const size_t max_length = max_value.getLength();
-    
-    BigInteger result = 0;
-    bool is_smaller = false;
-    for (int i = 1; i <= max_length; ++i) {
-        if (is_smaller) {
-            int new_digit = rand() % 10;
-            result = (result * 10) + new_digit;
-        } else {
-            int cur_digit = max_value.getDigitAt(i);
-            int new_digit = rand() % (cur_digit + 1);
-            
-            result = (result * 10) + new_digit;
-            is_smaller |= (new_digit < cur_digit);
-        }
-    }
-    return result;
+    return GetRandomNumberImpl(max_value, [](int bound) { return rand() % bound; });
 }
 
 BigInteger Crypto::GetRandomNumber(const BigInteger& min_value, const BigInteger& max_value) {
@@ -83,6 +259,18 @@ BigInteger Crypto::GetRandomNumber(const BigInteger& min_value, const BigInteger
     return min_value + GetRandomNumber(diff) - 1;
 }
 
+BigInteger Crypto::GetRandomNumber(const BigInteger& max_value, std::mt19937_64& gen) {
+    return GetRandomNumberImpl(max_value, [&gen](int bound) {
+        return std::uniform_int_distribution<int>(0, bound - 1)(gen);
+    });
+}
+
+BigInteger Crypto::GetRandomNumber(const BigInteger& min_value, const BigInteger& max_value,
+                                   std::mt19937_64& gen) {
+    BigInteger diff = max_value - min_value + 1;
+    return min_value + GetRandomNumber(diff, gen) - 1;
+}
+
 BigInteger Crypto::GetRandomNumberLen(int len) {
     BigInteger max_limit;
     for (int i = 1; i <= len; ++i) {
@@ -98,6 +286,57 @@ BigInteger Crypto::GetRandomNumberWithBitness(int bitness) {
     return GetRandomNumber(lhs, rhs);
 }
 
+void Crypto::GetSecureRandomBytes(void* buffer, size_t size) {
+    auto* bytes = static_cast<unsigned char*>(buffer);
+    while (size > 0) {
+        const ssize_t received = getrandom(bytes, size, 0);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error: getrandom failed" << std::endl;
+            exit(1);
+        }
+        bytes += received;
+        size -= static_cast<size_t>(received);
+    }
+}
+
+bool Crypto::GetSecureRandomBit() {
+    unsigned char byte = 0;
+    GetSecureRandomBytes(&byte, 1);
+    return byte & 1;
+}
+
+BigInteger Crypto::GetSecureRandomNumber(const BigInteger& min_value, const BigInteger& max_value) {
+    const BigInteger range = max_value - min_value;
+    std::string bytes = range.GetLittleEndianBytes();
+    if (range == 0 || bytes.empty()) {
+        return min_value;
+    }
+
+    // Rejection sampling over the bit length of range: fewer than two draws on average
+    unsigned int top_mask = 1;
+    while (top_mask < static_cast<unsigned char>(bytes.back())) {
+        top_mask = top_mask * 2 + 1;
+    }
+    while (true) {
+        GetSecureRandomBytes(bytes.data(), bytes.size());
+        bytes.back() = static_cast<char>(static_cast<unsigned char>(bytes.back()) & top_mask);
+        BigInteger value = BigInteger::GetFromLittleEndianBytes(
+                reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size());
+        if (value <= range) {
+            return min_value + value;
+        }
+    }
+}
+
+std::mt19937_64 Crypto::GetSeededRandomEngine() {
+    uint64_t seed = 0;
+    GetSecureRandomBytes(&seed, sizeof(seed));
+    return std::mt19937_64(seed);
+}
+
 BigInteger Crypto::GetClosestPrimeNumber(const BigInteger& src) {
     assert(src > 0);
     if (src == 1 || src == 2) {
@@ -114,6 +353,7 @@ BigInteger Crypto::GetClosestPrimeNumber(const BigInteger& src) {
 }
 
 std::vector<BigInteger> Crypto::GetRandomPrimeNumbers(const BigInteger& lhs, const BigInteger& rhs, int k) {
+    FS_TRACE_SPAN("Crypto::GetRandomPrimeNumbers");
     std::vector<BigInteger> result;
     result.reserve(k);
 
@@ -148,6 +388,7 @@ std::vector<BigInteger> Crypto::GetRandomPrimeNumbers(const BigInteger& lhs, con
 }
 
 std::vector<BigInteger> Crypto::GetFirstPrimeNumbers(const BigInteger& lhs, const BigInteger& rhs, int k) {
+    FS_TRACE_SPAN("Crypto::GetFirstPrimeNumbers");
     BigInteger last = lhs;
     std::vector<BigInteger> result;
     result.reserve(k);
@@ -180,44 +421,23 @@ std::vector<BigInteger> Crypto::GetFirstPrimeNumbersWithSomeBitness(int bitness,
 }
 
 bool Crypto::MillerRabinTest(const BigInteger& number) {
-    if (number == 2 || number == 3) {
-        return true;
-    }
-    if (number < 2 || number % 2 == 0) {
-        return false;
-    }
-    
-    int degree = 0;
-    BigInteger d = (number - 1);
-    BigInteger q = d;
-    while (d % 2 == 0) {
-        ++degree;
-        d /= 2;
-    }
-
-    for (int i = 0; i < std::max(10, degree); ++i) {
-        BigInteger alpha = GetRandomNumber(BigInteger(2), number - 2);
-        BigInteger x = BigInteger::pow(alpha, d, number);
-        if (x == 1 || x == q) {
-            continue;
-        }
-        for (int j = 1; j < degree; ++j) {
-            x = (x * x) % number;
-            if (x == 1) {
-                return false;
-            } else if (x == q) {
-                break;
-            }
-        }
+    FS_TRACE_SPAN("Crypto::MillerRabinTest");
+    DigitArena::Scope arena_scope;
+    return MillerRabinTestImpl(number, [](const BigInteger& lhs, const BigInteger& rhs) {
+        return GetRandomNumber(lhs, rhs);
+    });
+}
 
-        if (x != q) {
-            return false;
-        }
-    }
-    return true;
+bool Crypto::MillerRabinTest(const BigInteger& number, std::mt19937_64& gen) {
+    FS_TRACE_SPAN("Crypto::MillerRabinTest");
+    DigitArena::Scope arena_scope;
+    return MillerRabinTestImpl(number, [&gen](const BigInteger& lhs, const BigInteger& rhs) {
+        return GetRandomNumber(lhs, rhs, gen);
+    });
 }
 
 bool Crypto::LucasSelfridgeTest(const BigInteger& number) {
+    DigitArena::Scope arena_scope;
     if (number == 2) {
         return true;
     }
@@ -301,38 +521,31 @@ bool Crypto::LucasSelfridgeTest(const BigInteger& number) {
 }
 
 bool Crypto::BPSWTest(const BigInteger& number) {
-    if (number == 2) {
-        return true;
-    }
-    if (number < 2 || number % 2 == 0) {
-        return  false;
-    }
-    static std::vector<BigInteger> SmallPrimeNumbers{2, 3, 5, 7, 11, 13, 17, 19, 23, 29};
-    for (const auto& i : SmallPrimeNumbers) {
-        if (number == i) {
-            return true;
-        }
-        if (number % i == 0) {
-            return false;
-        }
-    }
-    if (!MillerRabinTest(number)) {
-        return false;
-    }
-    return LucasSelfridgeTest(number);
+    return BPSWTestImpl(number, [](const BigInteger& odd_number) { return MillerRabinTest(odd_number); });
+}
+
+bool Crypto::BPSWTest(const BigInteger& number, std::mt19937_64& gen) {
+    return BPSWTestImpl(number, [&gen](const BigInteger& odd_number) { return MillerRabinTest(odd_number, gen); });
 }
 
 void Crypto::PollardRhoAlgorithm(const BigInteger& number, std::vector<BigInteger>& result,
-                                 const int kLimit) {
+                                 const int kLimit, size_t threads_count) {
+    FS_TRACE_SPAN("Crypto::PollardRhoAlgorithm");
     int cur_limit = kLimit;
-    
+    if (threads_count == 0) {
+        threads_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
     if (number == 1) {
         return;
     }
-    if (number % 2 == 0) {
-        result.emplace_back(2);
-        PollardRhoAlgorithm(number / 2, result);
-        return;
+    // 2 and 5 divide R = 10^k, the walk needs n coprime with it
+    for (int small_prime : {2, 5}) {
+        if (number % small_prime == 0) {
+            result.emplace_back(small_prime);
+            PollardRhoAlgorithm(number / small_prime, result, kLimit, threads_count);
+            return;
+        }
     }
     if (MillerRabinTest(number)) {
         result.push_back(number);
@@ -341,27 +554,14 @@ void Crypto::PollardRhoAlgorithm(const BigInteger& number, std::vector<BigIntege
 
     while (cur_limit != 0) {
         --cur_limit;
-        
-        BigInteger x = GetRandomNumber(number);
-        BigInteger y = x;
-        BigInteger c = GetRandomNumber(number);
-        BigInteger g = 1;
-        BigInteger diff = 0;
-        
-        while (g == 1) {
-            x = ((x * x) % number + c) % number;
-            y = ((y * y) % number + c) % number;
-            y = ((y * y) % number + c) % number;
-            diff = BigInteger::abs(x - y);
-            g = BigInteger::gcd(diff, number);
-        }
-        
-        if (diff == 0) {
+
+        std::optional<BigInteger> divisor = FindDivisor(number, threads_count);
+        if (!divisor.has_value()) {
             continue;
         }
-        
-        PollardRhoAlgorithm(g, result, kLimit);
-        PollardRhoAlgorithm(number / g, result, kLimit);
+
+        PollardRhoAlgorithm(divisor.value(), result, kLimit, threads_count);
+        PollardRhoAlgorithm(number / divisor.value(), result, kLimit, threads_count);
         break;
     }
 
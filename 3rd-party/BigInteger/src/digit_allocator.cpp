@@ -0,0 +1,142 @@
+#include "digit_allocator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    struct Header {
+        DigitResource::Release release;
+        void* context;
+    };
+
+    constexpr size_t kAlignment = alignof(std::max_align_t);
+    constexpr size_t kHeaderSize = (sizeof(Header) + kAlignment - 1) / kAlignment * kAlignment;
+
+    size_t AlignUp(size_t bytes) {
+        return (bytes + kAlignment - 1) / kAlignment * kAlignment;
+    }
+
+    thread_local DigitResource* thread_resource = nullptr;
+}  // namespace
+
+DigitResourceScope::DigitResourceScope(DigitResource& resource) : previous_(thread_resource) {
+    thread_resource = &resource;
+}
+
+DigitResourceScope::DigitResourceScope(std::nullptr_t) : previous_(thread_resource) {
+    thread_resource = nullptr;
+}
+
+DigitResourceScope::~DigitResourceScope() {
+    thread_resource = previous_;
+}
+
+void* DigitAllocation::Allocate(size_t bytes) {
+    DigitResource::Block block;
+    if (thread_resource == nullptr) {
+        block = {::operator new(kHeaderSize + bytes), nullptr, nullptr};
+    } else {
+        block = thread_resource->allocate(kHeaderSize + bytes);
+    }
+
+    auto* header = static_cast<Header*>(block.memory);
+    header->release = block.release;
+    header->context = block.context;
+    return static_cast<unsigned char*>(block.memory) + kHeaderSize;
+}
+
+void DigitAllocation::Deallocate(void* ptr) noexcept {
+    void* block = static_cast<unsigned char*>(ptr) - kHeaderSize;
+    const auto* header = static_cast<const Header*>(block);
+    if (header->release == nullptr) {
+        ::operator delete(block);
+    } else {
+        header->release(block, header->context);
+    }
+}
+
+DigitArena::~DigitArena() {
+    for (Chunk* chunk : chunks_) {
+        releaseChunk(chunk);
+    }
+}
+
+DigitResource::Block DigitArena::allocate(size_t bytes) {
+    bytes = AlignUp(bytes);
+
+    // Temporaries die young: once every buffer of a chunk is freed it's rewound in place,
+    // so a long scope keeps cycling through a few cache-hot chunks instead of growing.
+    for (size_t visited = 0; visited < chunks_.size(); ++visited) {
+        Chunk* chunk = chunks_[current_];
+        if (chunk->references.load(std::memory_order_acquire) == 1) {
+            chunk->used = 0;
+        }
+        if (chunk->used + bytes <= chunk->capacity) {
+            break;
+        }
+        current_ = (current_ + 1) % chunks_.size();
+    }
+    if (chunks_.empty() || chunks_[current_]->used + bytes > chunks_[current_]->capacity) {
+        current_ = chunks_.size();
+        chunks_.push_back(createChunk(std::max(kChunkSize, bytes)));
+    }
+
+    Chunk* chunk = chunks_[current_];
+    void* memory = reinterpret_cast<unsigned char*>(chunk) + AlignUp(sizeof(Chunk)) + chunk->used;
+    chunk->used += bytes;
+    chunk->references.fetch_add(1, std::memory_order_relaxed);
+    return {memory, &DigitArena::releaseBlock, chunk};
+}
+
+void DigitArena::reset() {
+    size_t kept = 0;
+    for (Chunk* chunk : chunks_) {
+        // Only this thread allocates from the chunk, so a single reference means no live buffers
+        if (chunk->references.load(std::memory_order_acquire) == 1 && chunk->capacity == kChunkSize) {
+            chunk->used = 0;
+            chunks_[kept++] = chunk;
+        } else {
+            releaseChunk(chunk);
+        }
+    }
+    chunks_.resize(kept);
+    current_ = 0;
+}
+
+DigitArena& DigitArena::forThread() {
+    thread_local DigitArena arena;
+    return arena;
+}
+
+DigitArena::Chunk* DigitArena::createChunk(size_t capacity) {
+    void* memory = std::malloc(AlignUp(sizeof(Chunk)) + capacity);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    auto* chunk = new (memory) Chunk();
+    chunk->capacity = capacity;
+    return chunk;
+}
+
+void DigitArena::releaseChunk(Chunk* chunk) noexcept {
+    if (chunk->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        chunk->~Chunk();
+        std::free(chunk);
+    }
+}
+
+void DigitArena::releaseBlock(void*, void* context) noexcept {
+    releaseChunk(static_cast<Chunk*>(context));
+}
+
+DigitArena::Scope::Scope() : resource_scope_(forThread()) {
+    ++forThread().scope_depth_;
+}
+
+DigitArena::Scope::~Scope() {
+    DigitArena& arena = forThread();
+    if (--arena.scope_depth_ == 0) {
+        arena.reset();
+    }
+}
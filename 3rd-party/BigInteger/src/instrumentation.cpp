@@ -0,0 +1,249 @@
+#include "instrumentation.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace Instrumentation {
+namespace {
+    const char* const kCounterNames[kCountersCount] = {
+        "fiatshamir_bigint_allocations_total",
+        "fiatshamir_bigint_divisions_total",
+        "fiatshamir_bigint_modular_exponentiations_total"
+    };
+
+    const double kQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+    /// Only the owner thread writes, so plain load + store is enough; readers may see
+    /// a slightly stale value, which is fine for a snapshot.
+    struct ThreadCounters {
+        std::array<std::atomic<uint64_t>, kCountersCount> counters{};
+        std::array<std::atomic<uint64_t>, kMultiplicationSizeClasses> multiplications{};
+    };
+
+    /// Blocks outlive their threads, so totals of finished threads are kept.
+    struct CountersRegistry {
+        std::mutex mutex;
+        std::deque<ThreadCounters> blocks;
+    };
+
+    struct HistogramsRegistry {
+        std::mutex mutex;
+        std::map<std::string, std::unique_ptr<Histogram>> histograms;
+    };
+
+    CountersRegistry& GetCountersRegistry() {
+        static auto* registry = new CountersRegistry();
+        return *registry;
+    }
+
+    HistogramsRegistry& GetHistogramsRegistry() {
+        static auto* registry = new HistogramsRegistry();
+        return *registry;
+    }
+
+    ThreadCounters& GetThreadCounters() {
+        thread_local ThreadCounters* counters = [] {
+            CountersRegistry& registry = GetCountersRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            return &registry.blocks.emplace_back();
+        }();
+        return *counters;
+    }
+
+    void Bump(std::atomic<uint64_t>& value) {
+        value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    size_t GetMultiplicationSizeClass(size_t digits) {
+        size_t size_class = 0;
+        for (size_t bound = 16; digits > bound && size_class + 1 < kMultiplicationSizeClasses; bound *= 2) {
+            ++size_class;
+        }
+        return size_class;
+    }
+
+    std::string GetSizeClassLabel(size_t size_class) {
+        if (size_class + 1 == kMultiplicationSizeClasses) {
+            return "+Inf";
+        }
+        return std::to_string(size_t{16} << size_class);
+    }
+
+    std::string FormatSeconds(uint64_t nanoseconds) {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.9f", static_cast<double>(nanoseconds) * 1e-9);
+        return buffer;
+    }
+}  // namespace
+
+void Increment(Counter counter) {
+    Bump(GetThreadCounters().counters[static_cast<size_t>(counter)]);
+}
+
+void CountMultiplication(size_t digits) {
+    Bump(GetThreadCounters().multiplications[GetMultiplicationSizeClass(digits)]);
+}
+
+uint64_t GetCounter(Counter counter) {
+    CountersRegistry& registry = GetCountersRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    uint64_t total = 0;
+    for (const auto& block : registry.blocks) {
+        total += block.counters[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t GetMultiplications(size_t size_class) {
+    CountersRegistry& registry = GetCountersRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    uint64_t total = 0;
+    for (const auto& block : registry.blocks) {
+        total += block.multiplications[size_class].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+Histogram::Histogram(std::string name) : name_(std::move(name)) {}
+
+size_t Histogram::getBucketIndex(uint64_t value) {
+    if (value < kSubBuckets) {
+        return value;
+    }
+    // value = (16 + sub) * 2^(exponent - 4), 4 <= exponent <= 63
+    size_t exponent = 63 - __builtin_clzll(value);
+    size_t sub = (value >> (exponent - 4)) - kSubBuckets;
+    return (exponent - 3) * kSubBuckets + sub;
+}
+
+uint64_t Histogram::getBucketUpperBound(size_t index) {
+    if (index < kSubBuckets) {
+        return index;
+    }
+    size_t exponent = index / kSubBuckets + 3;
+    uint64_t sub = index % kSubBuckets;
+    uint64_t width = uint64_t{1} << (exponent - 4);
+    return (kSubBuckets + sub) * width + (width - 1);
+}
+
+void Histogram::record(uint64_t nanoseconds) {
+    buckets_[getBucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (max < nanoseconds && !max_.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed)) {}
+}
+
+const std::string& Histogram::getName() const {
+    return name_;
+}
+
+uint64_t Histogram::getCount() const {
+    return count_.load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::getSum() const {
+    return sum_.load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::getMax() const {
+    return max_.load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::getValueAtQuantile(double q) const {
+    uint64_t total = 0;
+    for (const auto& bucket : buckets_) {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketsCount; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(getBucketUpperBound(i), getMax());
+        }
+    }
+    return getMax();
+}
+
+Histogram& GetHistogram(const std::string& name) {
+    HistogramsRegistry& registry = GetHistogramsRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto& histogram = registry.histograms[name];
+    if (!histogram) {
+        histogram = std::make_unique<Histogram>(name);
+    }
+    return *histogram;
+}
+
+std::string ExportPrometheus() {
+    std::string result;
+    for (size_t i = 0; i < kCountersCount; ++i) {
+        result += "# TYPE " + std::string(kCounterNames[i]) + " counter\n";
+        result += kCounterNames[i] + (" " + std::to_string(GetCounter(static_cast<Counter>(i)))) + "\n";
+    }
+
+    result += "# TYPE fiatshamir_bigint_multiplications_total counter\n";
+    for (size_t size_class = 0; size_class < kMultiplicationSizeClasses; ++size_class) {
+        result += "fiatshamir_bigint_multiplications_total{digits_le=\"" + GetSizeClassLabel(size_class) +
+                  "\"} " + std::to_string(GetMultiplications(size_class)) + "\n";
+    }
+
+    HistogramsRegistry& registry = GetHistogramsRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const auto& [name, histogram] : registry.histograms) {
+        const std::string metric = "fiatshamir_" + name;
+        result += "# TYPE " + metric + " summary\n";
+        for (double q : kQuantiles) {
+            char quantile[16];
+            snprintf(quantile, sizeof(quantile), "%g", q);
+            result += metric + "{quantile=\"" + quantile + "\"} " +
+                      FormatSeconds(histogram->getValueAtQuantile(q)) + "\n";
+        }
+        result += metric + "_sum " + FormatSeconds(histogram->getSum()) + "\n";
+        result += metric + "_count " + std::to_string(histogram->getCount()) + "\n";
+    }
+    return result;
+}
+
+std::string ExportJson() {
+    std::string result = "{\"counters\": {";
+    for (size_t i = 0; i < kCountersCount; ++i) {
+        result += (i == 0 ? "\"" : ", \"") + std::string(kCounterNames[i]) + "\": " +
+                  std::to_string(GetCounter(static_cast<Counter>(i)));
+    }
+
+    result += "}, \"multiplications\": {";
+    for (size_t size_class = 0; size_class < kMultiplicationSizeClasses; ++size_class) {
+        result += (size_class == 0 ? "\"" : ", \"") + GetSizeClassLabel(size_class) + "\": " +
+                  std::to_string(GetMultiplications(size_class));
+    }
+
+    result += "}, \"histograms\": {";
+    HistogramsRegistry& registry = GetHistogramsRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    bool is_first = true;
+    for (const auto& [name, histogram] : registry.histograms) {
+        result += (is_first ? "\"" : ", \"") + name + "\": {\"count\": " + std::to_string(histogram->getCount()) +
+                  ", \"sum_ns\": " + std::to_string(histogram->getSum()) +
+                  ", \"max_ns\": " + std::to_string(histogram->getMax()) +
+                  ", \"p50_ns\": " + std::to_string(histogram->getValueAtQuantile(0.5)) +
+                  ", \"p90_ns\": " + std::to_string(histogram->getValueAtQuantile(0.9)) +
+                  ", \"p99_ns\": " + std::to_string(histogram->getValueAtQuantile(0.99)) +
+                  ", \"p999_ns\": " + std::to_string(histogram->getValueAtQuantile(0.999)) + "}";
+        is_first = false;
+    }
+    result += "}}\n";
+    return result;
+}
+}  // namespace Instrumentation
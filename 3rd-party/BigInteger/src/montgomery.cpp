@@ -0,0 +1,100 @@
+#include "montgomery.h"
+
+#include <cassert>
+#include <string>
+
+namespace {
+    BigInteger PowerOfTen(size_t exponent) {
+        return BigInteger("1" + std::string(exponent, '0'));
+    }
+}  // namespace
+
+MontgomeryContext::MontgomeryContext(const BigInteger& module)
+        : module_(module), digits_(module.getLength()) {
+    assert(IsSupported(module));
+
+    // m^(-1) mod 10 by search, then Hensel lifting: x' = x * (2 - m * x) mod 10^(2i)
+    BigInteger inverse = 1;
+    while ((module_.getLowDigits(1) * inverse).getLowDigits(1) != 1) {
+        inverse += 2;
+    }
+    for (size_t precision = 1; precision < digits_; ) {
+        precision = std::min(2 * precision, digits_);
+        BigInteger product = (module_.getLowDigits(precision) * inverse).getLowDigits(precision);
+        BigInteger correction = (inverse * product).getLowDigits(precision);
+        inverse = inverse * 2 - correction;
+        if (!inverse.IsPositive()) {
+            inverse += PowerOfTen(precision);
+        }
+        inverse = inverse.getLowDigits(precision);
+    }
+
+    const BigInteger r = PowerOfTen(digits_);
+    module_inverse_ = r - inverse;
+    r2_ = BigInteger::mod(PowerOfTen(2 * digits_), module_);
+    r3_ = BigInteger::mod(r2_ * r, module_);
+    module_times_r_ = module_ * r;
+}
+
+bool MontgomeryContext::IsSupported(const BigInteger& module) {
+    if (!module.IsPositive() || module <= 1) {
+        return false;
+    }
+    BigInteger::Digit last_digit = module.getDigitAt(module.getLength());
+    return last_digit % 2 != 0 && last_digit != 5;
+}
+
+const BigInteger& MontgomeryContext::getModule() const {
+    return module_;
+}
+
+BigInteger MontgomeryContext::toMontgomery(const BigInteger& x) const {
+    return reduce(x * r2_);
+}
+
+BigInteger MontgomeryContext::toMontgomeryWide(const BigInteger& x) const {
+    if (x >= module_times_r_) {
+        return toMontgomery(BigInteger::mod(x, module_));
+    }
+    // (x / R) * R^3 / R = x * R
+    return multiply(reduce(x), r3_);
+}
+
+BigInteger MontgomeryContext::fromMontgomery(const BigInteger& x) const {
+    return reduce(x);
+}
+
+BigInteger MontgomeryContext::multiply(const BigInteger& a, const BigInteger& b) const {
+    return reduce(a * b);
+}
+
+BigInteger MontgomeryContext::pow(const BigInteger& base, const BigInteger& exponent) const {
+    // Left-to-right over decimal digits: result = result^10 * base^digit
+    BigInteger table[10];
+    table[0] = reduce(r2_);
+    table[1] = base;
+    for (int i = 2; i < 10; ++i) {
+        table[i] = multiply(table[i - 1], base);
+    }
+
+    const auto& digits = exponent.data();
+    BigInteger result = table[digits.back()];
+    for (size_t i = digits.size() - 1; i > 0; --i) {
+        BigInteger square = multiply(result, result);
+        BigInteger fifth = multiply(multiply(square, square), result);
+        result = multiply(fifth, fifth);
+        if (digits[i - 1] != 0) {
+            result = multiply(result, table[digits[i - 1]]);
+        }
+    }
+    return result;
+}
+
+BigInteger MontgomeryContext::reduce(const BigInteger& t) const {
+    BigInteger factor = (t.getLowDigits(digits_) * module_inverse_).getLowDigits(digits_);
+    BigInteger result = (t + factor * module_).dropLowDigits(digits_);
+    if (result >= module_) {
+        result -= module_;
+    }
+    return result;
+}
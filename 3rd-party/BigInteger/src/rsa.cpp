@@ -2,10 +2,16 @@
 // Created by daniilsmelskiy on 10.04.21.
 //
 
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <iterator>
+#include <thread>
+
+#include <unistd.h>
 
 #include "crypto_algorithms.h"
-#include "chinese_remainder_theorem.h"
 
 #include "rsa.h"
 
@@ -51,23 +57,135 @@ BigInteger EuclideanExtended(const BigInteger& x, const BigInteger& y) {
 
     return a.back();
 }
+
+void StoreLittleEndian32(char* dst, uint32_t value) {
+    for (int i = 0; i < 4; ++i, value >>= 8) {
+        dst[i] = static_cast<char>(value & 0xff);
+    }
+}
+
+uint32_t LoadLittleEndian32(const char* src) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) {
+        value = (value << 8) | static_cast<unsigned char>(src[i]);
+    }
+    return value;
+}
+
+/// result[i] = function(i) for i < count, contiguous ranges per thread. Each value is computed
+/// in the thread's digit arena, only the result is copied out to the heap.
+template <typename Function>
+std::vector<BigInteger> GenerateInParallel(size_t count, size_t threads_count, const Function& function) {
+    if (threads_count == 0) {
+        threads_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads_count = std::min(threads_count, count);
+
+    std::vector<BigInteger> result(count);
+    auto generate_range = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            DigitArena::Scope arena_scope;
+            BigInteger value = function(i);
+
+            DigitResourceScope heap_scope(nullptr);
+            result[i] = value;
+        }
+    };
+
+    if (threads_count <= 1) {
+        generate_range(0, count);
+        return result;
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(threads_count);
+    for (size_t thread = 0; thread < threads_count; ++thread) {
+        threads.emplace_back(generate_range, count * thread / threads_count,
+                             count * (thread + 1) / threads_count);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return result;
+}
+
+/// result[i] = function(blocks[i]), see GenerateInParallel.
+template <typename Function>
+std::vector<BigInteger> TransformInParallel(std::span<const BigInteger> blocks, size_t threads_count,
+                                            const Function& function) {
+    return GenerateInParallel(blocks.size(), threads_count,
+                              [&blocks, &function](size_t i) { return function(blocks[i]); });
+}
+
+/// The first probable prime from a random point of [lhs, rhs] on, wrapping around to lhs past rhs.
+/// REQUIREMENT: rhs is odd, [lhs, rhs] contains a prime
+BigInteger FindRandomPrime(const BigInteger& lhs, const BigInteger& rhs, std::mt19937_64& gen) {
+    BigInteger candidate = Crypto::GetRandomNumber(lhs, rhs, gen);
+    if (candidate.IsEven()) {
+        candidate += 1;
+    }
+    while (!Crypto::BPSWTest(candidate, gen)) {
+        candidate += 2;
+        if (candidate > rhs) {
+            candidate = lhs.IsEven() ? lhs + 1 : lhs;
+        }
+    }
+    return candidate;
+}
+
+/// The smallest x in [lhs, rhs] with x^k >= value, by bisection.
+/// REQUIREMENT: rhs^k >= value
+BigInteger CeilRoot(const BigInteger& value, int k, BigInteger lhs, BigInteger rhs) {
+    while (lhs < rhs) {
+        BigInteger middle = (lhs + rhs) / 2;
+        if (BigInteger::pow(middle, k) >= value) {
+            rhs = std::move(middle);
+        } else {
+            lhs = middle + 1;
+        }
+    }
+    return lhs;
+}
 }  // namespace
 
 namespace RSA {
 
 void Bob::Init(const BigInteger &p, const BigInteger &q) {
-    p_ = p;
-    q_ = q;
-    n_ = p_ * q_;
+    Init(std::vector<BigInteger>{p, q});
+}
 
-    /// Euler function
-    /// phi_ = (p_ - 1) * (q_ - 1);
+void Bob::Init(std::vector<BigInteger> primes) {
+    std::sort(primes.begin(), primes.end());
 
     /// Carmichael function
-    phi_ = BigInteger::lcm(p_ - 1, q_ - 1);
+    n_ = 1;
+    phi_ = 1;
+    for (const auto& prime : primes) {
+        n_ *= prime;
+        phi_ = BigInteger::lcm(phi_, prime - 1);
+    }
 
     e_ = GetCoprime(phi_);
     d_ = EuclideanExtended(e_, phi_);
+
+    factors_.clear();
+    factors_.reserve(primes.size());
+    for (size_t i = 0; i < primes.size(); ++i) {
+        PrimeFactor factor;
+        factor.prime = primes[i];
+        factor.exponent = d_ % (primes[i] - 1);
+        if (MontgomeryContext::IsSupported(primes[i])) {
+            factor.context.emplace(primes[i]);
+        }
+
+        factor.inverses.reserve(i);
+        for (size_t j = 0; j < i; ++j) {
+            BigInteger inverse = primes[j] == primes[i] ? BigInteger(0)
+                                                        : EuclideanExtended(primes[j] % primes[i], primes[i]);
+            factor.inverses.push_back(factor.context.has_value() ? factor.context->toMontgomery(inverse) : inverse);
+        }
+        factors_.push_back(std::move(factor));
+    }
 }
 
 const BigInteger& Bob::GetModule() const {
@@ -86,58 +204,233 @@ Key Bob::GetPrivateKey() const {
     return {d_, n_};
 }
 
-BigInteger Bob::Decode(const BigInteger &c) {
-    BigInteger mp = BigInteger::pow(c, d_ % (p_ - 1), p_);
-    BigInteger mq = BigInteger::pow(c, d_ % (q_ - 1), q_);
+BigInteger Bob::Decode(const BigInteger &c) const {
+    /// Garner: m = v[0] + v[1] * p[0] + v[2] * p[0] * p[1] + ..., where
+    /// v[i] = (...((m[i] - v[0]) * p[0]^(-1) - v[1]) * p[1]^(-1) - ...) mod p[i], m[i] = c^d mod p[i].
+    /// Primes ascend, so v[j] < p[j] <= p[i] and adding p[i] once keeps every difference non-negative.
+    std::vector<BigInteger> v;
+    v.reserve(factors_.size());
+    for (const auto& factor : factors_) {
+        BigInteger value = DecodeModPrime(c, factor);
+        for (size_t j = 0; j < v.size(); ++j) {
+            value -= v[j];
+            if (!value.IsPositive()) {
+                value += factor.prime;
+            }
+            value = factor.context.has_value() ? factor.context->multiply(value, factor.inverses[j])
+                                               : BigInteger::mod(value * factor.inverses[j], factor.prime);
+        }
+        v.push_back(std::move(value));
+    }
 
-    CRT_Solver crt;
-    crt.add_equation(1, mp, p_);
-    crt.add_equation(1, mq, q_);
+    BigInteger message = v.back();
+    for (size_t i = v.size() - 1; i > 0; --i) {
+        message = message * factors_[i - 1].prime + v[i - 1];
+    }
+    return message;
+}
 
-    const BigInteger* message = crt.solve();
-    return *message;
+std::vector<BigInteger> Bob::DecodeBatch(std::span<const BigInteger> blocks, size_t threads_count) const {
+    return TransformInParallel(blocks, threads_count, [this](const BigInteger& c) { return Decode(c); });
+}
+
+BigInteger Bob::DecodeModPrime(const BigInteger& c, const PrimeFactor& factor) {
+    if (!factor.context.has_value()) {
+        return BigInteger::pow(c, factor.exponent, factor.prime);
+    }
+    const MontgomeryContext& context = factor.context.value();
+    return context.fromMontgomery(context.pow(context.toMontgomeryWide(c), factor.exponent));
 }
 
 void Alice::SetPublicKey(const Key &key) {
     public_key_ = key;
+    context_.reset();
+    if (MontgomeryContext::IsSupported(public_key_.mod)) {
+        context_.emplace(public_key_.mod);
+    }
+}
+
+const Key& Alice::GetPublicKey() const {
+    return public_key_;
 }
 
-BigInteger Alice::Encode(const BigInteger &message) {
+BigInteger Alice::Encode(const BigInteger &message) const {
+    if (context_.has_value()) {
+        return context_->fromMontgomery(context_->pow(context_->toMontgomeryWide(message), public_key_.value));
+    }
     BigInteger c = BigInteger::pow(message, public_key_.value, public_key_.mod);
     return c;
 }
 
+std::vector<BigInteger> Alice::EncodeBatch(std::span<const BigInteger> messages, size_t threads_count) const {
+    return TransformInParallel(messages, threads_count, [this](const BigInteger& m) { return Encode(m); });
+}
+
+ByteReader::ByteReader(std::istream& input) : input_(&input) {}
+
+ByteReader::ByteReader(int fd) : fd_(fd) {}
+
+size_t ByteReader::read(char* dst, size_t size) {
+    if (input_ != nullptr) {
+        input_->read(dst, static_cast<std::streamsize>(size));
+        has_failed_ = input_->bad();
+        return static_cast<size_t>(input_->gcount());
+    }
+
+    size_t done = 0;
+    while (done < size) {
+        ssize_t count = ::read(fd_, dst + done, size - done);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            has_failed_ = count < 0;
+            break;
+        }
+        done += static_cast<size_t>(count);
+    }
+    return done;
+}
+
+bool ByteReader::hasFailed() const {
+    return has_failed_;
+}
+
+ByteWriter::ByteWriter(std::ostream& output) : output_(&output) {}
+
+ByteWriter::ByteWriter(int fd) : fd_(fd) {}
+
+bool ByteWriter::write(const char* src, size_t size) {
+    if (output_ != nullptr) {
+        output_->write(src, static_cast<std::streamsize>(size));
+        return output_->good();
+    }
+
+    size_t done = 0;
+    while (done < size) {
+        ssize_t count = ::write(fd_, src + done, size - done);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        done += static_cast<size_t>(count);
+    }
+    return true;
+}
+
 std::vector<BigInteger> TextConvertor::ConvertFromText(const std::string &text, int symbol_size) {
     std::vector<BigInteger> result;
-    for (int i = 0; i < text.size(); i += symbol_size) {
-        BigInteger cur_symbol = 0;
-        int pos = std::min(static_cast<int>(text.size()) - 1, i + symbol_size - 1);
-        while (pos >= i) {
-            cur_symbol *= kAlphabetSize;
-            cur_symbol += ConvertToNumber(text[pos]);
-            --pos;
-        }
-        result.push_back(cur_symbol);
+    result.reserve((text.size() + symbol_size - 1) / symbol_size);
+    const auto* bytes = reinterpret_cast<const unsigned char*>(text.data());
+    for (size_t i = 0; i < text.size(); i += symbol_size) {
+        result.push_back(BigInteger::GetFromLittleEndianBytes(bytes + i, std::min<size_t>(symbol_size, text.size() - i)));
     }
     return result;
 }
 
 std::string TextConvertor::ConvertToText(BigInteger symbols) {
-    std::string result;
-    while (symbols > 0) {
-        int r = (symbols % kAlphabetSize).ToInt();
-        result += ConvertToChar(r);
-        symbols /= kAlphabetSize;
+    if (!symbols.IsPositive()) {
+        return {};
     }
-    return result;
+    return symbols.GetLittleEndianBytes();
 }
 
-unsigned char TextConvertor::ConvertToChar(int number) {
-    return static_cast<unsigned char>(number);
+size_t TextConvertor::ReadBlocks(ByteReader& input, int symbol_size, size_t max_blocks,
+                                 std::vector<BigInteger>& blocks) {
+    std::string buffer(max_blocks * symbol_size, '\0');
+    size_t size = input.read(buffer.data(), buffer.size());
+    buffer.resize(size);
+
+    std::vector<BigInteger> chunk = ConvertFromText(buffer, symbol_size);
+    blocks.insert(blocks.end(), std::make_move_iterator(chunk.begin()), std::make_move_iterator(chunk.end()));
+    return size;
 }
 
-int TextConvertor::ConvertToNumber(unsigned char c) {
-    return static_cast<int>(c);
+bool TextConvertor::WriteBlocks(ByteWriter& output, std::span<const BigInteger> blocks, int symbol_size, size_t size) {
+    std::string buffer(size, '\0');
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        size_t offset = i * symbol_size;
+        if (offset >= size) {
+            return false;
+        }
+        std::string bytes = ConvertToText(blocks[i]);
+        if (bytes.size() > std::min<size_t>(symbol_size, size - offset)) {
+            return false;
+        }
+        std::copy(bytes.begin(), bytes.end(), buffer.begin() + static_cast<std::ptrdiff_t>(offset));
+    }
+    return output.write(buffer.data(), buffer.size());
+}
+
+bool EncodeStream(const Alice& alice, int symbol_size, ByteReader& input, ByteWriter& output,
+                  size_t threads_count) {
+    const size_t cipher_width = alice.GetPublicKey().mod.GetLittleEndianBytes().size();
+
+    std::vector<BigInteger> blocks;
+    std::string record;
+    while (true) {
+        blocks.clear();
+        size_t size = TextConvertor::ReadBlocks(input, symbol_size, kStreamChunkBlocks, blocks);
+        if (input.hasFailed()) {
+            return false;
+        }
+        if (size == 0) {
+            return true;
+        }
+
+        std::vector<BigInteger> ciphers = alice.EncodeBatch(blocks, threads_count);
+        record.assign(4 + ciphers.size() * cipher_width, '\0');
+        StoreLittleEndian32(record.data(), static_cast<uint32_t>(size));
+        for (size_t i = 0; i < ciphers.size(); ++i) {
+            std::string bytes = ciphers[i].GetLittleEndianBytes();
+            std::copy(bytes.begin(), bytes.end(), record.begin() + static_cast<std::ptrdiff_t>(4 + i * cipher_width));
+        }
+        if (!output.write(record.data(), record.size())) {
+            return false;
+        }
+    }
+}
+
+bool DecodeStream(const Bob& bob, int symbol_size, ByteReader& input, ByteWriter& output,
+                  size_t threads_count) {
+    const size_t cipher_width = bob.GetModule().GetLittleEndianBytes().size();
+    const size_t max_size = kStreamChunkBlocks * symbol_size;
+
+    std::vector<BigInteger> ciphers;
+    std::string buffer;
+    while (true) {
+        char header[4];
+        size_t header_size = input.read(header, sizeof(header));
+        if (header_size == 0 && !input.hasFailed()) {
+            return true;
+        }
+        if (header_size != sizeof(header)) {
+            return false;
+        }
+
+        size_t size = LoadLittleEndian32(header);
+        if (size == 0 || size > max_size) {
+            return false;
+        }
+        size_t blocks_count = (size + symbol_size - 1) / symbol_size;
+        buffer.resize(blocks_count * cipher_width);
+        if (input.read(buffer.data(), buffer.size()) != buffer.size()) {
+            return false;
+        }
+
+        ciphers.clear();
+        const auto* bytes = reinterpret_cast<const unsigned char*>(buffer.data());
+        for (size_t i = 0; i < blocks_count; ++i) {
+            ciphers.push_back(BigInteger::GetFromLittleEndianBytes(bytes + i * cipher_width, cipher_width));
+        }
+
+        std::vector<BigInteger> blocks = bob.DecodeBatch(ciphers, threads_count);
+        if (!TextConvertor::WriteBlocks(output, blocks, symbol_size, size)) {
+            return false;
+        }
+    }
 }
 
 Bob MakeBob(int len) {
@@ -150,6 +443,52 @@ Bob MakeBob(int len) {
     return bob;
 }
 
+std::optional<Bob> MakeMultiPrimeBob(int modulus_bitness, int primes_count) {
+    if (primes_count < 2 || modulus_bitness / primes_count < kMinMultiPrimeBitness) {
+        return std::nullopt;
+    }
+
+    // Prime i has bitness b_i, the b_i add up to modulus_bitness, and it is at least 2^(b_i - 1/k)
+    // for k = primes_count. So the product is at least 2^(modulus_bitness - 1): N has exactly
+    // modulus_bitness bits.
+    std::vector<int> bitness(primes_count, modulus_bitness / primes_count);
+    for (int i = 0; i < modulus_bitness % primes_count; ++i) {
+        ++bitness[i];
+    }
+    auto get_range = [primes_count](int prime_bitness) {
+        BigInteger lhs = BigInteger::pow(2, prime_bitness - 1);
+        BigInteger rhs = BigInteger::pow(2, prime_bitness) - 1;
+        lhs = CeilRoot(BigInteger::pow(2, prime_bitness * primes_count - 1), primes_count, lhs, rhs);
+        return std::make_pair(std::move(lhs), std::move(rhs));
+    };
+    // At most two distinct bitnesses
+    const auto long_range = get_range(bitness.front());
+    const auto short_range = get_range(bitness.back());
+    auto range_of = [&](int i) -> const std::pair<BigInteger, BigInteger>& {
+        return bitness[i] == bitness.front() ? long_range : short_range;
+    };
+
+    // Every search owns an engine, so the threads don't share rand()
+    std::vector<BigInteger> primes = GenerateInParallel(primes_count, primes_count, [&range_of](size_t i) {
+        std::mt19937_64 gen = Crypto::GetSeededRandomEngine();
+        const auto& [lhs, rhs] = range_of(static_cast<int>(i));
+        return FindRandomPrime(lhs, rhs, gen);
+    });
+
+    // Independent draws may collide for small bitness
+    std::mt19937_64 gen = Crypto::GetSeededRandomEngine();
+    for (int i = 0; i < primes_count; ++i) {
+        while (std::count(primes.begin(), primes.end(), primes[i]) > 1) {
+            primes[i] = FindRandomPrime(range_of(i).first, range_of(i).second, gen);
+        }
+    }
+
+    RSA::Bob bob;
+    bob.Init(std::move(primes));
+
+    return bob;
+}
+
 BigInteger GetHash(const BigInteger& key, const BigInteger& mod, const std::string& message) {
     BigInteger result = 0;
     BigInteger step = 1;
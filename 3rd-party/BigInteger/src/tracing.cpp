@@ -0,0 +1,150 @@
+#include "tracing.h"
+
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <unistd.h>
+
+namespace Tracing {
+namespace {
+    std::atomic<bool> is_enabled{false};
+
+    /// Slots are guarded by a sequence number: odd while the owner thread writes,
+    /// so a concurrent reader can detect and skip a torn slot without locking.
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<const char*> name{nullptr};
+        std::atomic<uint64_t> start_ns{0};
+        std::atomic<uint64_t> duration_ns{0};
+    };
+
+    struct RingBuffer {
+        explicit RingBuffer(uint32_t tid) : tid(tid), slots(kRingBufferCapacity) {}
+
+        uint32_t tid;
+        std::atomic<uint64_t> written{0};
+        std::vector<Slot> slots;
+    };
+
+    /// Buffers outlive their threads, so spans of finished threads are still flushed.
+    struct Registry {
+        std::mutex mutex;
+        std::deque<RingBuffer> buffers;
+    };
+
+    Registry& GetRegistry() {
+        static auto* registry = new Registry();
+        return *registry;
+    }
+
+    RingBuffer& GetThreadBuffer() {
+        thread_local RingBuffer* buffer = [] {
+            Registry& registry = GetRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            return &registry.buffers.emplace_back(static_cast<uint32_t>(registry.buffers.size() + 1));
+        }();
+        return *buffer;
+    }
+
+    uint64_t GetNowNs() {
+        static const auto kEpoch = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::steady_clock::now() - kEpoch;
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
+
+    void Record(const char* name, uint64_t start_ns, uint64_t duration_ns) {
+        RingBuffer& buffer = GetThreadBuffer();
+        uint64_t index = buffer.written.load(std::memory_order_relaxed);
+        Slot& slot = buffer.slots[index % kRingBufferCapacity];
+
+        uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.start_ns.store(start_ns, std::memory_order_relaxed);
+        slot.duration_ns.store(duration_ns, std::memory_order_relaxed);
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+
+        buffer.written.store(index + 1, std::memory_order_release);
+    }
+
+    void WriteEscaped(FILE* file, const char* text) {
+        for (; *text != '\0'; ++text) {
+            if (*text == '"' || *text == '\\') {
+                fputc('\\', file);
+            }
+            fputc(*text, file);
+        }
+    }
+}  // namespace
+
+void Enable() {
+    GetNowNs();
+    is_enabled.store(true, std::memory_order_relaxed);
+}
+
+void Disable() {
+    is_enabled.store(false, std::memory_order_relaxed);
+}
+
+bool IsEnabled() {
+    return is_enabled.load(std::memory_order_relaxed);
+}
+
+Span::Span(const char* name) {
+    if (!IsEnabled()) {
+        return;
+    }
+    name_ = name;
+    start_ns_ = GetNowNs();
+}
+
+Span::~Span() {
+    if (name_ != nullptr) {
+        Record(name_, start_ns_, GetNowNs() - start_ns_);
+    }
+}
+
+bool WriteChromeTrace(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+
+    const int pid = static_cast<int>(getpid());
+    bool is_first = true;
+    fprintf(file, "{\"traceEvents\": [\n");
+
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const RingBuffer& buffer : registry.buffers) {
+        uint64_t written = buffer.written.load(std::memory_order_acquire);
+        uint64_t begin = written > kRingBufferCapacity ? written - kRingBufferCapacity : 0;
+
+        for (uint64_t index = begin; index < written; ++index) {
+            const Slot& slot = buffer.slots[index % kRingBufferCapacity];
+            uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const char* name = slot.name.load(std::memory_order_relaxed);
+            uint64_t start_ns = slot.start_ns.load(std::memory_order_relaxed);
+            uint64_t duration_ns = slot.duration_ns.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence % 2 != 0 || sequence != slot.sequence.load(std::memory_order_relaxed) || name == nullptr) {
+                continue;
+            }
+
+            fprintf(file, "%s{\"name\": \"", is_first ? "" : ",\n");
+            WriteEscaped(file, name);
+            fprintf(file, "\", \"ph\": \"X\", \"pid\": %d, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+                    pid, buffer.tid, static_cast<double>(start_ns) * 1e-3, static_cast<double>(duration_ns) * 1e-3);
+            is_first = false;
+        }
+    }
+
+    fprintf(file, "\n], \"displayTimeUnit\": \"ns\"}\n");
+    return fclose(file) == 0;
+}
+}  // namespace Tracing
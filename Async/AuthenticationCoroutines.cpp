@@ -0,0 +1,100 @@
+#include "AuthenticationCoroutines.h"
+
+#include <optional>
+
+#include "WireFormat.h"
+
+#include "crypto_algorithms.h"
+
+namespace {
+    template <typename Decoder>
+    auto DecodeFrame(const std::optional<Frame>& frame, Decoder decode)
+            -> decltype(decode(std::declval<Wire::Message>())) {
+        if (!frame.has_value()) {
+            return std::nullopt;
+        }
+
+        Wire::Reader reader(frame.value());
+        const auto message = reader.next();
+        if (!message.has_value() || !reader.isAtEnd()) {
+            return std::nullopt;
+        }
+        return decode(message.value());
+    }
+
+    Frame ToFrame(const Wire::Writer& writer) {
+        return writer.data();
+    }
+}  // namespace
+
+Task<bool> RunProver(User& user, Endpoint endpoint) {
+    Wire::Writer message;
+    message.writeBeginSession(user.getUserId());
+    endpoint.send(ToFrame(message));
+
+    auto status = DecodeFrame(co_await endpoint.receive(), Wire::DecodeStatus);
+
+    while (status == Wire::Status::OK || status == Wire::Status::CONTINUE) {
+        message.clear();
+        message.writeCommitment(user.initAuthentication());
+        endpoint.send(ToFrame(message));
+
+        const auto challenge = DecodeFrame(co_await endpoint.receive(), Wire::DecodeChallenge);
+        if (!challenge.has_value() || challenge->size() != 1) {
+            break;
+        }
+
+        const auto response = user.processChallenge(challenge->front());
+        if (!response.has_value()) {
+            break;
+        }
+
+        message.clear();
+        message.writeResponse(response.value());
+        endpoint.send(ToFrame(message));
+
+        status = DecodeFrame(co_await endpoint.receive(), Wire::DecodeStatus);
+    }
+
+    endpoint.close();
+    co_return status == Wire::Status::ACCEPTED;
+}
+
+Task<bool> RunVerifier(const CentralAuthority& ca, Endpoint endpoint, uint32_t rounds_count) {
+    Wire::Writer message;
+
+    const auto user_id = DecodeFrame(co_await endpoint.receive(), Wire::DecodeBeginSession);
+    const BigInteger* public_key = user_id.has_value() ? ca.getUserPublicKey(user_id.value()) : nullptr;
+
+    message.writeStatus(!public_key ? Wire::Status::FAILED
+                                    : rounds_count > 0 ? Wire::Status::OK
+                                                       : Wire::Status::ACCEPTED);
+    endpoint.send(ToFrame(message));
+
+    bool is_accepted = (public_key != nullptr);
+    for (uint32_t round = 0; is_accepted && round < rounds_count; ++round) {
+        const auto commitment = DecodeFrame(co_await endpoint.receive(), Wire::DecodeCommitment);
+        if (!commitment.has_value()) {
+            is_accepted = false;
+            break;
+        }
+
+        const bool challenge = Crypto::GetSecureRandomBit();
+        message.clear();
+        message.writeChallenge({challenge});
+        endpoint.send(ToFrame(message));
+
+        const auto response = DecodeFrame(co_await endpoint.receive(), Wire::DecodeResponse);
+        is_accepted = response.has_value() &&
+                      ca.verifyRound(*public_key, commitment.value(), challenge, response.value());
+
+        message.clear();
+        message.writeStatus(!is_accepted ? Wire::Status::REJECTED
+                                         : round + 1 < rounds_count ? Wire::Status::CONTINUE
+                                                                    : Wire::Status::ACCEPTED);
+        endpoint.send(ToFrame(message));
+    }
+
+    endpoint.close();
+    co_return is_accepted;
+}
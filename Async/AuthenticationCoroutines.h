@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+#include "CentralAuthority.h"
+#include "User.h"
+
+#include "InMemoryTransport.h"
+#include "Task.h"
+
+/// Protocol state machines as coroutines: all per-session state lives in the coroutine frame,
+/// and a coroutine gives its thread away whenever it waits for the next message.
+/// Frames carry Wire messages, in the same order as AuthenticationServer expects them.
+/// Each coroutine owns its endpoint and closes it when done.
+
+/// Begins a session for the user and answers challenges until the verifier decides.
+/// Returns true if the user was accepted.
+Task<bool> RunProver(User& user, Endpoint endpoint);
+
+/// Serves one session: t commitment/challenge/response rounds.
+/// Returns true if the prover was accepted.
+Task<bool> RunVerifier(const CentralAuthority& ca, Endpoint endpoint, uint32_t rounds_count);
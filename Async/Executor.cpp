@@ -0,0 +1,80 @@
+#include "Executor.h"
+
+namespace {
+    /// Owns the spawned task and destroys itself when the task is over.
+    struct DetachedTask {
+        struct promise_type {
+            DetachedTask get_return_object() {
+                return DetachedTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+
+            std::suspend_always initial_suspend() noexcept {
+                return {};
+            }
+
+            std::suspend_never final_suspend() noexcept {
+                return {};
+            }
+
+            void return_void() {}
+
+            void unhandled_exception() {
+                std::terminate();
+            }
+        };
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    template <typename OnFinished>
+    DetachedTask RunDetached(Task<void> task, OnFinished on_finished) {
+        co_await task;
+        on_finished();
+    }
+}  // namespace
+
+void Executor::spawn(Task<void> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++active_tasks_count_;
+    }
+
+    const auto detached = RunDetached(std::move(task), [this]() { onTaskFinished(); });
+    schedule(detached.handle);
+}
+
+void Executor::schedule(std::coroutine_handle<> handle) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(handle);
+    }
+    has_work_.notify_one();
+}
+
+void Executor::run() {
+    while (true) {
+        std::coroutine_handle<> handle;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            has_work_.wait(lock, [this]() { return !queue_.empty() || active_tasks_count_ == 0; });
+
+            if (queue_.empty()) {
+                return;
+            }
+            handle = queue_.front();
+            queue_.pop_front();
+        }
+        handle.resume();
+    }
+}
+
+void Executor::onTaskFinished() {
+    bool is_idle = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        is_idle = (--active_tasks_count_ == 0);
+    }
+    if (is_idle) {
+        has_work_.notify_all();
+    }
+}
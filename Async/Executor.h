@@ -0,0 +1,78 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <mutex>
+
+#include "Task.h"
+
+/// Run queue of suspended coroutines.
+/// Any number of threads may call run() to share the work.
+class Executor {
+  public:
+    Executor() = default;
+
+    Executor(const Executor&) = delete;
+    Executor& operator = (const Executor&) = delete;
+
+    /// Starts the task on the executor. The executor owns it until it finishes.
+    void spawn(Task<void> task);
+
+    /// Same for a task with a result, which becomes ready when the task finishes,
+    /// e.g. once run() returns.
+    template <typename T>
+    std::future<T> spawn(Task<T> task);
+
+    /// Queues a suspended coroutine to be resumed by one of the run() threads.
+    void schedule(std::coroutine_handle<> handle);
+
+    /// Resumes queued coroutines until all spawned tasks are finished.
+    void run();
+
+    /// Awaiting the result moves the coroutine to the back of the run queue.
+    auto yield() {
+        struct YieldAwaiter {
+            Executor& executor;
+
+            bool await_ready() const noexcept {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> handle) {
+                executor.schedule(handle);
+            }
+
+            void await_resume() noexcept {}
+        };
+        return YieldAwaiter{*this};
+    }
+
+  private:
+    void onTaskFinished();
+
+    std::mutex mutex_;
+    std::condition_variable has_work_;
+    std::deque<std::coroutine_handle<>> queue_;
+    size_t active_tasks_count_{0};
+};
+
+namespace Detail {
+
+template <typename T>
+Task<void> StoreResult(Task<T> task, std::promise<T> result) {
+    result.set_value(co_await task);
+}
+
+}  // namespace Detail
+
+template <typename T>
+std::future<T> Executor::spawn(Task<T> task) {
+    std::promise<T> result;
+    std::future<T> future = result.get_future();
+
+    spawn(Detail::StoreResult(std::move(task), std::move(result)));
+    return future;
+}
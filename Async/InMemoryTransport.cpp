@@ -0,0 +1,70 @@
+#include "InMemoryTransport.h"
+
+FrameChannel::FrameChannel(Executor& executor)
+    : executor_(executor) {
+}
+
+void FrameChannel::send(Frame frame) {
+    std::coroutine_handle<> receiver;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        frames_.push_back(std::move(frame));
+        receiver = std::exchange(receiver_, nullptr);
+    }
+    if (receiver) {
+        executor_.schedule(receiver);
+    }
+}
+
+void FrameChannel::close() {
+    std::coroutine_handle<> receiver;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        is_closed_ = true;
+        receiver = std::exchange(receiver_, nullptr);
+    }
+    if (receiver) {
+        executor_.schedule(receiver);
+    }
+}
+
+bool FrameChannel::suspendReceiver(std::coroutine_handle<> handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!frames_.empty() || is_closed_) {
+        return false;
+    }
+    receiver_ = handle;
+    return true;
+}
+
+std::optional<Frame> FrameChannel::popFrame() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (frames_.empty()) {
+        return std::nullopt;
+    }
+
+    Frame result = std::move(frames_.front());
+    frames_.pop_front();
+    return result;
+}
+
+Endpoint::Endpoint(std::shared_ptr<FrameChannel> incoming, std::shared_ptr<FrameChannel> outgoing)
+    : incoming_(std::move(incoming)),
+      outgoing_(std::move(outgoing)) {
+}
+
+void Endpoint::send(Frame frame) {
+    outgoing_->send(std::move(frame));
+}
+
+void Endpoint::close() {
+    outgoing_->close();
+}
+
+std::pair<Endpoint, Endpoint> MakeInMemoryConnection(Executor& executor) {
+    auto first_to_second = std::make_shared<FrameChannel>(executor);
+    auto second_to_first = std::make_shared<FrameChannel>(executor);
+
+    return {Endpoint(second_to_first, first_to_second),
+            Endpoint(first_to_second, second_to_first)};
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <coroutine>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "Executor.h"
+
+using Frame = std::vector<unsigned char>;
+
+/// One-directional queue of frames with a single awaiting receiver.
+class FrameChannel {
+  public:
+    explicit FrameChannel(Executor& executor);
+
+    void send(Frame frame);
+
+    /// Wakes the receiver; it gets std::nullopt once the queued frames are drained.
+    void close();
+
+    /// co_await channel.receive() yields std::optional<Frame>.
+    auto receive() {
+        struct ReceiveAwaiter {
+            FrameChannel& channel;
+
+            bool await_ready() const noexcept {
+                return false;
+            }
+
+            bool await_suspend(std::coroutine_handle<> handle) {
+                return channel.suspendReceiver(handle);
+            }
+
+            std::optional<Frame> await_resume() {
+                return channel.popFrame();
+            }
+        };
+        return ReceiveAwaiter{*this};
+    }
+
+  private:
+    /// Returns false if a frame is already available and the receiver shouldn't suspend.
+    bool suspendReceiver(std::coroutine_handle<> handle);
+    std::optional<Frame> popFrame();
+
+    Executor& executor_;
+
+    std::mutex mutex_;
+    std::deque<Frame> frames_;
+    std::coroutine_handle<> receiver_;
+    bool is_closed_{false};
+};
+
+/// One side of an in-memory duplex connection.
+class Endpoint {
+  public:
+    Endpoint(std::shared_ptr<FrameChannel> incoming, std::shared_ptr<FrameChannel> outgoing);
+
+    void send(Frame frame);
+
+    auto receive() {
+        return incoming_->receive();
+    }
+
+    /// Tells the peer that nothing more will be sent.
+    void close();
+
+  private:
+    std::shared_ptr<FrameChannel> incoming_;
+    std::shared_ptr<FrameChannel> outgoing_;
+};
+
+/// Connected pair of endpoints whose receivers are resumed on the executor.
+std::pair<Endpoint, Endpoint> MakeInMemoryConnection(Executor& executor);
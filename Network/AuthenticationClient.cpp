@@ -0,0 +1,196 @@
+#include "AuthenticationClient.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    constexpr size_t kFrameHeaderSize = 5;
+
+    bool ReadExactly(int fd, unsigned char* dst, size_t size) {
+        while (size > 0) {
+            const ssize_t received = read(fd, dst, size);
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            if (received <= 0) {
+                return false;
+            }
+            dst += received;
+            size -= static_cast<size_t>(received);
+        }
+        return true;
+    }
+}  // namespace
+
+AuthenticationClient::AuthenticationClient(int fd)
+    : fd_(fd) {
+}
+
+AuthenticationClient::~AuthenticationClient() {
+    close(fd_);
+}
+
+std::unique_ptr<AuthenticationClient> AuthenticationClient::connectUnix(const std::string& path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        return nullptr;
+    }
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, path.c_str());
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return nullptr;
+    }
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return nullptr;
+    }
+
+    return std::unique_ptr<AuthenticationClient>(new AuthenticationClient(fd));
+}
+
+std::unique_ptr<AuthenticationClient> AuthenticationClient::connectTcp(uint16_t port) {
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    const int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return nullptr;
+    }
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return nullptr;
+    }
+
+    const int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+    return std::unique_ptr<AuthenticationClient>(new AuthenticationClient(fd));
+}
+
+std::optional<BigInteger> AuthenticationClient::requestModule() {
+    Wire::Writer request;
+    request.writeModuleRequest();
+
+    if (!send(request)) {
+        return std::nullopt;
+    }
+    return receive(Wire::DecodeModule);
+}
+
+bool AuthenticationClient::registerUser(const User& user) {
+    Wire::Writer request;
+    request.writeRegister(user.getUserId(), user.getPublicKey());
+
+    return exchangeForStatus(request) == Wire::Status::OK;
+}
+
+bool AuthenticationClient::authenticate(User& user) {
+    Wire::Writer request;
+    request.writeBeginSession(user.getUserId());
+
+    if (exchangeForStatus(request) != Wire::Status::OK) {
+        return false;
+    }
+
+    while (true) {
+        request.clear();
+        request.writeCommitment(user.initAuthentication());
+
+        if (!send(request)) {
+            return false;
+        }
+        const auto challenge = receive(Wire::DecodeChallenge);
+        if (!challenge.has_value() || challenge->size() != 1) {
+            return false;
+        }
+
+        const auto response = user.processChallenge(challenge->front());
+        if (!response.has_value()) {
+            return false;
+        }
+
+        request.clear();
+        request.writeResponse(response.value());
+
+        const auto status = exchangeForStatus(request);
+        if (status != Wire::Status::CONTINUE) {
+            return status == Wire::Status::ACCEPTED;
+        }
+    }
+}
+
+bool AuthenticationClient::authenticatePipelined(User& user, uint32_t rounds_count) {
+    Wire::Writer request;
+    request.writeBeginSession(user.getUserId());
+
+    if (exchangeForStatus(request) != Wire::Status::OK) {
+        return false;
+    }
+
+    request.clear();
+    request.writeCommitments(user.initAuthentication(rounds_count));
+
+    if (!send(request)) {
+        return false;
+    }
+    const auto challenges = receive(Wire::DecodeChallenge);
+    const auto responses = challenges.has_value() ? user.processChallenges(challenges.value()) : std::nullopt;
+    if (!responses.has_value()) {
+        return false;
+    }
+
+    request.clear();
+    request.writeResponses(responses.value());
+
+    return exchangeForStatus(request) == Wire::Status::ACCEPTED;
+}
+
+bool AuthenticationClient::send(const Wire::Writer& messages) {
+    const auto& data = messages.data();
+
+    size_t sent = 0;
+    while (sent < data.size()) {
+        const ssize_t written = ::send(fd_, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(written);
+    }
+    return true;
+}
+
+std::optional<Wire::Status> AuthenticationClient::exchangeForStatus(const Wire::Writer& request) {
+    if (!send(request)) {
+        return std::nullopt;
+    }
+    return receive(Wire::DecodeStatus);
+}
+
+bool AuthenticationClient::receiveFrame() {
+    frame_.resize(kFrameHeaderSize);
+    if (!ReadExactly(fd_, frame_.data(), kFrameHeaderSize)) {
+        return false;
+    }
+
+    size_t payload_size = 0;
+    for (size_t i = 4; i > 0; --i) {
+        payload_size = (payload_size << 8) | frame_[i];
+    }
+
+    frame_.resize(kFrameHeaderSize + payload_size);
+    return ReadExactly(fd_, frame_.data() + kFrameHeaderSize, payload_size);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "big_integer.h"
+
+#include "User.h"
+#include "WireFormat.h"
+
+/// Blocking prover side of AuthenticationServer's protocol.
+class AuthenticationClient {
+  public:
+    ~AuthenticationClient();
+
+    AuthenticationClient(const AuthenticationClient&) = delete;
+    AuthenticationClient& operator = (const AuthenticationClient&) = delete;
+
+    /// Return nullptr if the server isn't reachable.
+    static std::unique_ptr<AuthenticationClient> connectUnix(const std::string& path);
+    static std::unique_ptr<AuthenticationClient> connectTcp(uint16_t port);
+
+    std::optional<BigInteger> requestModule();
+
+    bool registerUser(const User& user);
+
+    /// Runs all rounds of the protocol for the user.
+    bool authenticate(User& user);
+
+    /// Pipelined mode: three messages instead of 3t.
+    /// rounds_count has to match the server's t, or the server closes the connection.
+    bool authenticatePipelined(User& user, uint32_t rounds_count);
+
+  private:
+    explicit AuthenticationClient(int fd);
+
+    bool send(const Wire::Writer& messages);
+
+    /// Blocks until a whole frame arrives, then decodes it.
+    template <typename Decoder>
+    auto receive(Decoder decode) -> decltype(decode(std::declval<Wire::Message>()));
+
+    std::optional<Wire::Status> exchangeForStatus(const Wire::Writer& request);
+
+    bool receiveFrame();
+
+    int fd_;
+    std::vector<unsigned char> frame_;
+};
+
+template <typename Decoder>
+auto AuthenticationClient::receive(Decoder decode) -> decltype(decode(std::declval<Wire::Message>())) {
+    if (!receiveFrame()) {
+        return std::nullopt;
+    }
+
+    Wire::Reader reader(frame_);
+    const auto message = reader.next();
+    if (!message.has_value()) {
+        return std::nullopt;
+    }
+    return decode(message.value());
+}
@@ -0,0 +1,390 @@
+#include "AuthenticationServer.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    constexpr int kMaxEvents = 256;
+    constexpr size_t kReadChunkSize = 16 * 1024;
+    /// Connections that send more unparsed data than this are dropped.
+    constexpr size_t kMaxInputSize = 1024 * 1024;
+    /// A connection isn't read while more than this is waiting to be sent to it.
+    constexpr size_t kMaxPendingOutput = 1024 * 1024;
+
+    bool SetNonBlocking(int fd) {
+        const int flags = fcntl(fd, F_GETFL, 0);
+        return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+}  // namespace
+
+AuthenticationServer::AuthenticationServer(CentralAuthority& ca, VerifierService& verifier,
+                                           bool allow_registration)
+    : ca_(ca),
+      verifier_(verifier),
+      allow_registration_(allow_registration) {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        std::cerr << "Error: Can't create epoll instance: " << std::strerror(errno) << std::endl;
+        return;
+    }
+
+    wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = wakeup_fd_;
+    if (wakeup_fd_ < 0 || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &event) != 0) {
+        std::cerr << "Error: Can't create wakeup eventfd: " << std::strerror(errno) << std::endl;
+        if (wakeup_fd_ >= 0) {
+            close(wakeup_fd_);
+            wakeup_fd_ = -1;
+        }
+    }
+}
+
+AuthenticationServer::~AuthenticationServer() {
+    for (const auto& connection : connections_) {
+        close(connection.first);
+    }
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+    }
+    if (!unix_path_.empty()) {
+        unlink(unix_path_.c_str());
+    }
+    if (wakeup_fd_ >= 0) {
+        close(wakeup_fd_);
+    }
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+}
+
+bool AuthenticationServer::listenUnix(const std::string& path) {
+    // The constructor has reported why they are missing
+    if (epoll_fd_ < 0 || wakeup_fd_ < 0) {
+        return false;
+    }
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, path.c_str());
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    unlink(path.c_str());
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        std::cerr << "Error: Can't bind '" << path << "': " << std::strerror(errno) << std::endl;
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+
+    unix_path_ = path;
+    return startListening(fd);
+}
+
+bool AuthenticationServer::listenTcp(uint16_t port) {
+    // The constructor has reported why they are missing
+    if (epoll_fd_ < 0 || wakeup_fd_ < 0) {
+        return false;
+    }
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    const int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    const int enable = 1;
+    if (fd < 0 ||
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) != 0 ||
+        bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        std::cerr << "Error: Can't bind port " << port << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+
+    return startListening(fd);
+}
+
+bool AuthenticationServer::startListening(int listen_fd) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listen_fd;
+
+    if (listen(listen_fd, SOMAXCONN) != 0 || !SetNonBlocking(listen_fd) ||
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd, &event) != 0) {
+        std::cerr << "Error: Can't listen: " << std::strerror(errno) << std::endl;
+        close(listen_fd);
+        return false;
+    }
+
+    listen_fd_ = listen_fd;
+    return true;
+}
+
+void AuthenticationServer::run() {
+    epoll_event events[kMaxEvents];
+
+    while (!is_stopping_.load()) {
+        const int events_count = epoll_wait(epoll_fd_, events, kMaxEvents, -1);
+        if (events_count < 0 && errno != EINTR) {
+            std::cerr << "Error: epoll_wait failed: " << std::strerror(errno) << std::endl;
+            return;
+        }
+
+        for (int i = 0; i < events_count; ++i) {
+            const int fd = events[i].data.fd;
+
+            if (fd == wakeup_fd_) {
+                continue;
+            }
+            if (fd == listen_fd_) {
+                acceptConnections();
+                continue;
+            }
+
+            const auto connection_it = connections_.find(fd);
+            if (connection_it == connections_.end()) {
+                continue;
+            }
+
+            Connection& connection = *connection_it->second;
+            bool is_alive = true;
+            if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                is_alive = readFromConnection(connection);
+            }
+            if (is_alive) {
+                is_alive = writeToConnection(connection);
+            }
+            if (!is_alive) {
+                closeConnection(fd);
+            }
+        }
+    }
+}
+
+void AuthenticationServer::stop() {
+    is_stopping_.store(true);
+
+    const uint64_t value = 1;
+    [[maybe_unused]] const auto written = write(wakeup_fd_, &value, sizeof(value));
+}
+
+void AuthenticationServer::acceptConnections() {
+    while (true) {
+        const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+
+        const int enable = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            continue;
+        }
+
+        connections_[fd] = std::make_unique<Connection>(fd);
+        connections_[fd]->watched_events = EPOLLIN;
+    }
+}
+
+bool AuthenticationServer::readFromConnection(Connection& connection) {
+    unsigned char chunk[kReadChunkSize];
+
+    /// Every chunk is parsed right away, so neither buffer grows by more than a chunk's worth
+    /// past its limit; the rest stays in the socket until the peer reads its replies.
+    while (connection.getPendingOutputSize() <= kMaxPendingOutput) {
+        const ssize_t received = read(connection.fd, chunk, kReadChunkSize);
+
+        if (received == 0) {
+            return false;
+        }
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+
+        connection.input.insert(connection.input.end(), chunk, chunk + received);
+
+        Wire::Reader reader(connection.input);
+        while (const auto message = reader.next()) {
+            if (!processMessage(connection, message.value())) {
+                return false;
+            }
+        }
+        connection.input.erase(connection.input.begin(),
+                               connection.input.begin() + static_cast<long>(reader.getPosition()));
+
+        if (connection.input.size() > kMaxInputSize) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool AuthenticationServer::writeToConnection(Connection& connection) {
+    const auto& output = connection.output.data();
+
+    while (connection.output_sent < output.size()) {
+        const ssize_t sent = send(connection.fd, output.data() + connection.output_sent,
+                                  output.size() - connection.output_sent, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                return false;
+            }
+            break;
+        }
+        connection.output_sent += static_cast<size_t>(sent);
+    }
+
+    if (connection.output_sent == output.size()) {
+        connection.output.clear();
+        connection.output_sent = 0;
+    }
+
+    return updateWatchedEvents(connection);
+}
+
+bool AuthenticationServer::updateWatchedEvents(Connection& connection) {
+    const size_t pending_output = connection.getPendingOutputSize();
+    const uint32_t events = (pending_output <= kMaxPendingOutput ? static_cast<uint32_t>(EPOLLIN) : 0) |
+                            (pending_output > 0 ? static_cast<uint32_t>(EPOLLOUT) : 0);
+    if (connection.watched_events == events) {
+        return true;
+    }
+
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = connection.fd;
+    connection.watched_events = events;
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection.fd, &event) == 0;
+}
+
+void AuthenticationServer::closeConnection(int fd) {
+    const auto connection_it = connections_.find(fd);
+    if (connection_it != connections_.end() && connection_it->second->session_id.has_value()) {
+        verifier_.endSession(connection_it->second->session_id.value());
+    }
+
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections_.erase(fd);
+}
+
+bool AuthenticationServer::processMessage(Connection& connection, const Wire::Message& message) {
+    switch (message.type) {
+        case Wire::MessageType::MODULE_REQUEST: {
+            connection.output.writeModule(ca_.getModule());
+            return true;
+        }
+        case Wire::MessageType::REGISTER: {
+            auto user = allow_registration_ ? Wire::DecodeRegister(message) : std::nullopt;
+            if (!user.has_value()) {
+                return false;
+            }
+            const auto status = ca_.registerUsers({std::move(user.value())});
+            connection.output.writeStatus(status[0] == RegistrationStatus::REGISTERED ? Wire::Status::OK
+                                                                                      : Wire::Status::FAILED);
+            return true;
+        }
+        case Wire::MessageType::BEGIN_SESSION: {
+            const auto user_id = Wire::DecodeBeginSession(message);
+            if (!user_id.has_value()) {
+                return false;
+            }
+            if (connection.session_id.has_value()) {
+                verifier_.endSession(connection.session_id.value());
+            }
+            connection.session_id = verifier_.beginSession(user_id.value());
+            connection.output.writeStatus(connection.session_id.has_value() ? Wire::Status::OK
+                                                                            : Wire::Status::FAILED);
+            return true;
+        }
+        case Wire::MessageType::COMMITMENT: {
+            const auto commitment = Wire::DecodeCommitment(message);
+            if (!commitment.has_value() || !connection.session_id.has_value()) {
+                return false;
+            }
+            const auto challenge = verifier_.submitCommitment(connection.session_id.value(), commitment.value());
+            if (!challenge.has_value()) {
+                return false;
+            }
+            connection.output.writeChallenge({challenge.value()});
+            return true;
+        }
+        case Wire::MessageType::RESPONSE: {
+            const auto response = Wire::DecodeResponse(message);
+            if (!response.has_value() || !connection.session_id.has_value()) {
+                return false;
+            }
+            writeRoundResult(connection, verifier_.submitResponse(connection.session_id.value(), response.value()));
+            return true;
+        }
+        case Wire::MessageType::COMMITMENTS: {
+            auto commitments = Wire::DecodeCommitments(message);
+            if (!commitments.has_value() || !connection.session_id.has_value()) {
+                return false;
+            }
+            const auto challenges = verifier_.submitCommitments(connection.session_id.value(),
+                                                                std::move(commitments.value()));
+            if (!challenges.has_value()) {
+                return false;
+            }
+            connection.output.writeChallenge(challenges.value());
+            return true;
+        }
+        case Wire::MessageType::RESPONSES: {
+            const auto responses = Wire::DecodeResponses(message);
+            if (!responses.has_value() || !connection.session_id.has_value()) {
+                return false;
+            }
+            writeRoundResult(connection, verifier_.submitResponses(connection.session_id.value(), responses.value()));
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+void AuthenticationServer::writeRoundResult(Connection& connection, RoundResult result) {
+    switch (result) {
+        case RoundResult::CONTINUE:
+            connection.output.writeStatus(Wire::Status::CONTINUE);
+            break;
+        case RoundResult::ACCEPTED:
+            connection.output.writeStatus(Wire::Status::ACCEPTED);
+            connection.session_id.reset();
+            break;
+        default:
+            connection.output.writeStatus(Wire::Status::REJECTED);
+            connection.session_id.reset();
+            break;
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CentralAuthority.h"
+#include "VerifierService.h"
+#include "WireFormat.h"
+
+/// Single-threaded epoll front end of the verifier.
+/// Serves any number of non-blocking connections over a Unix domain socket or loopback TCP.
+///
+/// Conversation with a prover, one Wire frame per step:
+///   MODULE_REQUEST -> MODULE
+///   REGISTER -> STATUS (OK or FAILED), only if allow_registration; otherwise the connection is closed
+///   BEGIN_SESSION -> STATUS (OK or FAILED)
+///   COMMITMENT -> CHALLENGE, RESPONSE -> STATUS (CONTINUE, ACCEPTED or REJECTED), repeated
+///   or, pipelined: COMMITMENTS -> CHALLENGE with t bits, RESPONSES -> STATUS (ACCEPTED or REJECTED)
+///
+/// Registration is unauthenticated, so it's off unless the server is trusted to run on a private socket.
+/// A connection that doesn't read its replies isn't read either while over 1 MB of them is queued.
+class AuthenticationServer {
+  public:
+    AuthenticationServer(CentralAuthority& ca, VerifierService& verifier, bool allow_registration = false);
+    ~AuthenticationServer();
+
+    AuthenticationServer(const AuthenticationServer&) = delete;
+    AuthenticationServer& operator = (const AuthenticationServer&) = delete;
+
+    bool listenUnix(const std::string& path);
+    bool listenTcp(uint16_t port);
+
+    /// Serves connections until stop() is called.
+    void run();
+
+    /// Thread-safe.
+    void stop();
+
+  private:
+    struct Connection {
+        explicit Connection(int fd) : fd(fd) {}
+
+        size_t getPendingOutputSize() const {
+            return output.data().size() - output_sent;
+        }
+
+        int fd;
+        std::vector<unsigned char> input;
+        Wire::Writer output;
+        size_t output_sent{0};
+        /// Events the connection is registered for in epoll
+        uint32_t watched_events{0};
+        std::optional<SessionId> session_id;
+    };
+
+    bool startListening(int listen_fd);
+
+    void acceptConnections();
+    /// Returns false if the connection has to be closed.
+    bool readFromConnection(Connection& connection);
+    bool writeToConnection(Connection& connection);
+    /// Watches EPOLLIN while the pending output is under the cap and EPOLLOUT while it isn't empty.
+    bool updateWatchedEvents(Connection& connection);
+    void closeConnection(int fd);
+
+    /// Returns false on protocol violations.
+    bool processMessage(Connection& connection, const Wire::Message& message);
+
+    /// Replies with the status and forgets the session once it's closed.
+    static void writeRoundResult(Connection& connection, RoundResult result);
+
+    CentralAuthority& ca_;
+    VerifierService& verifier_;
+    const bool allow_registration_;
+
+    /// -1 if the constructor couldn't create them; listenUnix and listenTcp then fail.
+    int epoll_fd_{-1};
+    int wakeup_fd_{-1};
+    int listen_fd_{-1};
+    std::string unix_path_;
+
+    std::atomic<bool> is_stopping_{false};
+    std::unordered_map<int, std::unique_ptr<Connection>> connections_;
+};
@@ -4,25 +4,78 @@
 
 #include "CentralAuthority.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include "crypto_algorithms.h"
+#include "instrumentation.h"
+#include "tracing.h"
 
-CentralAuthority::CentralAuthority() {
-    BigInteger p = Crypto::GetRandomPrimeNumbersWithSomeBitness(32)[0];
-    BigInteger q = Crypto::GetRandomPrimeNumbersWithSomeBitness(32)[0];
+namespace {
+    /// Smaller registration batches are validated on the calling thread.
+    constexpr size_t kMinParallelRegistrationBatch = 64;
+
+    /// x = y = 0 (or any multiple of a factor of N) satisfies y^2 == x * v^e for every
+    /// challenge, so commitments and responses have to be units: 1 <= value < N, gcd(value, N) == 1.
+    bool IsUnit(const BigInteger& value, const BigInteger& n) {
+        return value >= 1 && value < n && BigInteger::gcd(value, n) == 1;
+    }
+}  // namespace
+
+CentralAuthority::CentralAuthority(int prime_bitness) {
+    BigInteger p = Crypto::GetRandomPrimeNumbersWithSomeBitness(prime_bitness)[0];
+    BigInteger q = Crypto::GetRandomPrimeNumbersWithSomeBitness(prime_bitness)[0];
 
     n_ = p * q;
 }
 
-std::optional<BigInteger> CentralAuthority::getUserPublicKey(const std::string& user_id) const {
-    const auto& user_it = key_by_user_id_.find(user_id);
+CentralAuthority::CentralAuthority(std::unique_ptr<PublicKeyStore> key_store)
+    : n_(key_store->getModule()),
+      key_store_(std::move(key_store)) {
+}
+
+std::unique_ptr<CentralAuthority> CentralAuthority::fromKeyStore(const std::string& path) {
+    auto key_store = PublicKeyStore::open(path);
 
-    if (user_it == key_by_user_id_.end()) {
-        return std::nullopt;
+    if (!key_store) {
+        return nullptr;
     }
 
-    return user_it->second;
+    return std::unique_ptr<CentralAuthority>(new CentralAuthority(std::move(key_store)));
+}
+
+bool CentralAuthority::saveKeyStore(const std::string& path) const {
+    std::vector<std::pair<std::string, BigInteger>> users;
+
+    key_by_user_id_.forEach([&users](const std::string& user_id, const BigInteger& public_key) {
+        users.emplace_back(user_id, public_key);
+    });
+    if (key_store_) {
+        key_store_->forEach([this, &users](std::string user_id, BigInteger public_key) {
+            if (key_by_user_id_.find(user_id) == nullptr) {
+                users.emplace_back(std::move(user_id), std::move(public_key));
+            }
+        });
+    }
+
+    return PublicKeyStore::write(path, n_, users);
+}
+
+const BigInteger* CentralAuthority::getUserPublicKey(const std::string& user_id) const {
+    const BigInteger* public_key = key_by_user_id_.find(user_id);
+
+    if (public_key != nullptr || !key_store_) {
+        return public_key;
+    }
+
+    /// Decoding happens before the registry's writer mutex is taken; under it the key is only moved.
+    auto stored_key = key_store_->find(user_id);
+    if (!stored_key.has_value()) {
+        return nullptr;
+    }
+
+    key_by_user_id_.insert(user_id, std::move(stored_key.value()));
+    return key_by_user_id_.find(user_id);
 }
 
 const BigInteger& CentralAuthority::getModule() const {
@@ -30,11 +83,149 @@ const BigInteger& CentralAuthority::getModule() const {
 }
 
 void CentralAuthority::registerUser(const std::string& user_id, const BigInteger& public_key) {
-    if (key_by_user_id_.find(user_id) == key_by_user_id_.end()) {
+    FS_LATENCY_SCOPE("register_user_seconds");
+    FS_TRACE_SPAN("CentralAuthority::registerUser");
+    if (!isStored(user_id) && key_by_user_id_.insert(user_id, public_key)) {
         std::cout << "New user '" << user_id << "' with public key '"
                   << public_key << "' was registered." << std::endl;
-        key_by_user_id_[user_id] = public_key;
     } else {
         std::cerr << "Error: User '" << user_id << "' is already registered." << std::endl;
     }
 }
+
+std::vector<RegistrationStatus> CentralAuthority::registerUsers(
+        const std::vector<std::pair<std::string, BigInteger>>& users,
+        bool check_jacoby_symbol) {
+    FS_TRACE_SPAN("CentralAuthority::registerUsers");
+    std::vector<RegistrationStatus> result(users.size());
+
+    auto validate_range = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            result[i] = validatePublicKey(users[i].second, check_jacoby_symbol);
+        }
+    };
+
+    if (users.size() < kMinParallelRegistrationBatch) {
+        validate_range(0, users.size());
+    } else {
+        ThreadPool& workers = getRegistrationWorkers();
+        const size_t chunk_size = (users.size() + workers.size() - 1) / workers.size();
+
+        std::vector<std::future<void>> chunks;
+        for (size_t begin = 0; begin < users.size(); begin += chunk_size) {
+            const size_t end = std::min(users.size(), begin + chunk_size);
+            chunks.push_back(workers.submit([&validate_range, begin, end]() {
+                validate_range(begin, end);
+            }));
+        }
+        for (auto& chunk : chunks) {
+            chunk.get();
+        }
+    }
+
+    std::vector<size_t> valid_indices;
+    std::vector<std::pair<std::string, BigInteger>> valid_users;
+    for (size_t i = 0; i < users.size(); ++i) {
+        if (result[i] == RegistrationStatus::REGISTERED && isStored(users[i].first)) {
+            result[i] = RegistrationStatus::ALREADY_REGISTERED;
+        }
+        if (result[i] == RegistrationStatus::REGISTERED) {
+            valid_indices.push_back(i);
+            valid_users.push_back(users[i]);
+        }
+    }
+
+    const auto inserted = key_by_user_id_.insertBatch(std::move(valid_users));
+    for (size_t i = 0; i < valid_indices.size(); ++i) {
+        if (!inserted[i]) {
+            result[valid_indices[i]] = RegistrationStatus::ALREADY_REGISTERED;
+        }
+    }
+
+    return result;
+}
+
+bool CentralAuthority::isStored(const std::string& user_id) const {
+    return key_store_ && key_store_->contains(user_id);
+}
+
+ThreadPool& CentralAuthority::getRegistrationWorkers() {
+    std::call_once(registration_workers_flag_, [this]() {
+        registration_workers_ = std::make_unique<ThreadPool>();
+    });
+    return *registration_workers_;
+}
+
+RegistrationStatus CentralAuthority::validatePublicKey(const BigInteger& public_key,
+                                                       bool check_jacoby_symbol) const {
+    if (public_key < 1 || public_key >= n_) {
+        return RegistrationStatus::KEY_OUT_OF_RANGE;
+    }
+    if (BigInteger::gcd(public_key, n_) != 1) {
+        return RegistrationStatus::KEY_NOT_COPRIME;
+    }
+    if (check_jacoby_symbol && Crypto::JacobySymbol(public_key, n_) != 1) {
+        return RegistrationStatus::KEY_NOT_QUADRATIC_RESIDUE;
+    }
+    return RegistrationStatus::REGISTERED;
+}
+
+bool CentralAuthority::verifyRound(const BigInteger& public_key, const BigInteger& commitment,
+                                   bool challenge, const BigInteger& response) const {
+    FS_LATENCY_SCOPE("verify_round_seconds");
+    FS_TRACE_SPAN("CentralAuthority::verifyRound");
+    DigitArena::Scope arena_scope;
+    if (!IsUnit(commitment, n_) || !IsUnit(response, n_)) {
+        return false;
+    }
+
+    BigInteger expected_value = challenge ? (commitment * public_key) % n_
+                                          : commitment;
+
+    return expected_value == (response * response) % n_;
+}
+
+bool CentralAuthority::verifyTranscript(const AuthenticationTranscript& transcript) const {
+    const BigInteger* public_key = getUserPublicKey(transcript.user_id);
+
+    if (public_key == nullptr) {
+        return false;
+    }
+
+    return verifyRound(*public_key, transcript.commitment,
+                       transcript.challenge, transcript.response);
+}
+
+bool CentralAuthority::verifyRounds(const std::string& user_id,
+                                    const std::vector<BigInteger>& commitments,
+                                    const std::vector<bool>& challenges,
+                                    const std::vector<BigInteger>& responses) const {
+    FS_TRACE_SPAN("CentralAuthority::verifyRounds");
+    const BigInteger* public_key = getUserPublicKey(user_id);
+
+    if (public_key == nullptr || commitments.empty() ||
+        challenges.size() != commitments.size() || responses.size() != commitments.size()) {
+        return false;
+    }
+
+    /// Every round costs two multiplications, which is cheaper than any random linear combination.
+    for (size_t i = 0; i < commitments.size(); ++i) {
+        if (!verifyRound(*public_key, commitments[i], challenges[i], responses[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<size_t> CentralAuthority::verifyBatch(
+        const std::vector<AuthenticationTranscript>& transcripts) const {
+    FS_TRACE_SPAN("CentralAuthority::verifyBatch");
+    std::vector<size_t> rejected;
+
+    for (size_t i = 0; i < transcripts.size(); ++i) {
+        if (!verifyTranscript(transcripts[i])) {
+            rejected.push_back(i);
+        }
+    }
+    return rejected;
+}
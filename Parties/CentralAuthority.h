@@ -4,23 +4,96 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
 #include <string>
-#include <map>
-#include <optional>
+#include <utility>
+#include <vector>
 
 #include "big_integer.h"
 
+#include "PublicKeyRegistry.h"
+#include "PublicKeyStore.h"
+#include "ThreadPool.h"
+
+/// One commitment/challenge/response round of the protocol: y^2 == x * v^e (mod N).
+struct AuthenticationTranscript {
+    std::string user_id;
+    BigInteger commitment;
+    bool challenge{false};
+    BigInteger response;
+};
+
+enum class RegistrationStatus {
+    REGISTERED,
+    ALREADY_REGISTERED,
+    KEY_OUT_OF_RANGE,
+    KEY_NOT_COPRIME,
+    KEY_NOT_QUADRATIC_RESIDUE
+};
+
 class CentralAuthority {
   public:
-    CentralAuthority();
+    /// N is a product of two random primes of the given bitness.
+    explicit CentralAuthority(int prime_bitness = 32);
 
-    std::optional<BigInteger> getUserPublicKey(const std::string& user_id) const;
+    /// Maps a store written by saveKeyStore and takes N from it.
+    /// Stored keys are decoded on their first lookup.
+    /// Returns nullptr if the store can't be opened.
+    static std::unique_ptr<CentralAuthority> fromKeyStore(const std::string& path);
+
+    /// Writes all registered users into a store file. Returns false on I/O errors.
+    bool saveKeyStore(const std::string& path) const;
+
+    /// Returns nullptr if the user isn't registered.
+    /// Lookups don't lock, and the key stays valid for the lifetime of the authority.
+    const BigInteger* getUserPublicKey(const std::string& user_id) const;
 
     const BigInteger& getModule() const;
 
     void registerUser(const std::string& user_id, const BigInteger& public_key);
 
+    /// Validates keys in parallel, on a pool created by the first large batch and kept
+    /// for later calls, and registers the valid ones without console output.
+    /// A valid key v satisfies 1 <= v < N and gcd(v, N) == 1, and, if requested, (v | N) == 1,
+    /// which holds for every square v = s^2 mod N.
+    /// Returns a status for every entry, in the same order.
+    std::vector<RegistrationStatus> registerUsers(
+            const std::vector<std::pair<std::string, BigInteger>>& users,
+            bool check_jacoby_symbol = false);
+
+    /// Checks y^2 == x * v^e (mod N) for the given public key v.
+    /// x and y must be units of Z_N: 1 <= x, y < N and coprime with N.
+    bool verifyRound(const BigInteger& public_key, const BigInteger& commitment,
+                     bool challenge, const BigInteger& response) const;
+
+    bool verifyTranscript(const AuthenticationTranscript& transcript) const;
+
+    /// Checks all rounds of a pipelined authentication in one pass.
+    bool verifyRounds(const std::string& user_id,
+                      const std::vector<BigInteger>& commitments,
+                      const std::vector<bool>& challenges,
+                      const std::vector<BigInteger>& responses) const;
+
+    /// Checks every transcript on its own: a round costs two multiplications mod N,
+    /// which no random linear combination of the rounds undercuts.
+    /// Returns indices of the rejected transcripts in increasing order.
+    std::vector<size_t> verifyBatch(const std::vector<AuthenticationTranscript>& transcripts) const;
+
   private:
+    explicit CentralAuthority(std::unique_ptr<PublicKeyStore> key_store);
+
+    bool isStored(const std::string& user_id) const;
+
+    ThreadPool& getRegistrationWorkers();
+
+    RegistrationStatus validatePublicKey(const BigInteger& public_key, bool check_jacoby_symbol) const;
+
     BigInteger n_;
-    std::map<std::string, BigInteger> key_by_user_id_;
+    /// Also caches keys decoded from key_store_
+    mutable PublicKeyRegistry key_by_user_id_;
+    std::unique_ptr<PublicKeyStore> key_store_;
+
+    std::once_flag registration_workers_flag_;
+    std::unique_ptr<ThreadPool> registration_workers_;
 };
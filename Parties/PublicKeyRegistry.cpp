@@ -0,0 +1,116 @@
+#include "PublicKeyRegistry.h"
+
+namespace {
+    constexpr size_t kInitialCapacity = 16;
+}  // namespace
+
+PublicKeyRegistry::Table::Table(size_t capacity)
+    : mask(capacity - 1),
+      slots(new std::atomic<const Entry*>[capacity]) {
+    for (size_t i = 0; i < capacity; ++i) {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+PublicKeyRegistry::PublicKeyRegistry() {
+    tables_.push_back(std::make_unique<Table>(kInitialCapacity));
+    table_.store(tables_.back().get(), std::memory_order_release);
+}
+
+const BigInteger* PublicKeyRegistry::find(const std::string& user_id) const {
+    const size_t hash = std::hash<std::string>{}(user_id);
+    const Entry* entry = findInTable(*table_.load(std::memory_order_acquire), user_id, hash);
+
+    return entry ? &entry->public_key : nullptr;
+}
+
+bool PublicKeyRegistry::insert(const std::string& user_id, BigInteger public_key) {
+    const size_t hash = std::hash<std::string>{}(user_id);
+
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+
+    if (findInTable(*table_.load(std::memory_order_relaxed), user_id, hash)) {
+        return false;
+    }
+
+    reserveForInsertion(1);
+
+    entries_.push_back({user_id, std::move(public_key), hash});
+    insertIntoTable(*table_.load(std::memory_order_relaxed), &entries_.back());
+    size_.fetch_add(1, std::memory_order_release);
+
+    return true;
+}
+
+std::vector<bool> PublicKeyRegistry::insertBatch(std::vector<std::pair<std::string, BigInteger>>&& entries) {
+    std::vector<bool> result(entries.size(), false);
+
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+
+    reserveForInsertion(entries.size());
+
+    Table& table = *table_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const size_t hash = std::hash<std::string>{}(entries[i].first);
+
+        if (findInTable(table, entries[i].first, hash)) {
+            continue;
+        }
+
+        entries_.push_back({std::move(entries[i].first), std::move(entries[i].second), hash});
+        insertIntoTable(table, &entries_.back());
+        result[i] = true;
+    }
+    size_.store(entries_.size(), std::memory_order_release);
+
+    return result;
+}
+
+size_t PublicKeyRegistry::size() const {
+    return size_.load(std::memory_order_acquire);
+}
+
+const PublicKeyRegistry::Entry* PublicKeyRegistry::findInTable(const Table& table,
+                                                               const std::string& user_id,
+                                                               size_t hash) {
+    for (size_t pos = hash & table.mask; ; pos = (pos + 1) & table.mask) {
+        const Entry* entry = table.slots[pos].load(std::memory_order_acquire);
+
+        if (entry == nullptr) {
+            return nullptr;
+        }
+        if (entry->hash == hash && entry->user_id == user_id) {
+            return entry;
+        }
+    }
+}
+
+void PublicKeyRegistry::insertIntoTable(Table& table, const Entry* entry) {
+    size_t pos = entry->hash & table.mask;
+    while (table.slots[pos].load(std::memory_order_relaxed) != nullptr) {
+        pos = (pos + 1) & table.mask;
+    }
+    table.slots[pos].store(entry, std::memory_order_release);
+}
+
+void PublicKeyRegistry::reserveForInsertion(size_t new_entries_count) {
+    /// Load factor stays at most 1/2, so probe sequences are short and always end on an empty slot.
+    const size_t required_capacity = 2 * (entries_.size() + new_entries_count);
+
+    const Table* current_table = table_.load(std::memory_order_relaxed);
+    size_t capacity = current_table->mask + 1;
+    if (capacity >= required_capacity) {
+        return;
+    }
+    while (capacity < required_capacity) {
+        capacity *= 2;
+    }
+
+    auto new_table = std::make_unique<Table>(capacity);
+    for (const auto& entry : entries_) {
+        insertIntoTable(*new_table, &entry);
+    }
+
+    table_.store(new_table.get(), std::memory_order_release);
+    tables_.push_back(std::move(new_table));
+}
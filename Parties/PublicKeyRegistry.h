@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "big_integer.h"
+
+/// Append-only open-addressing hash table of public keys.
+/// Lookups never lock: they probe an immutable-size table whose slots are filled
+/// with release stores. Registrations are serialized by a writer mutex.
+/// When a table gets half full, writers publish a twice larger copy and keep the
+/// old one alive until the registry is destroyed, so readers never see freed memory.
+class PublicKeyRegistry {
+  public:
+    PublicKeyRegistry();
+
+    PublicKeyRegistry(const PublicKeyRegistry&) = delete;
+    PublicKeyRegistry& operator = (const PublicKeyRegistry&) = delete;
+
+    /// Returns nullptr if the user isn't registered.
+    /// The returned key stays valid until the registry is destroyed.
+    const BigInteger* find(const std::string& user_id) const;
+
+    /// Returns false if the user is already registered.
+    /// The key is moved in, so a caller that decoded it doesn't pay for a second copy.
+    bool insert(const std::string& user_id, BigInteger public_key);
+
+    /// Inserts all entries in one pass with at most one growth of the table.
+    /// For every entry returns whether it was inserted: ids that are already registered,
+    /// including ones repeated earlier in the same batch, are skipped.
+    std::vector<bool> insertBatch(std::vector<std::pair<std::string, BigInteger>>&& entries);
+
+    size_t size() const;
+
+    /// Calls visitor(user_id, public_key) for every registered user.
+    /// Registrations wait until the visit is over.
+    template <typename Visitor>
+    void forEach(Visitor&& visitor);
+
+  private:
+    struct Entry {
+        std::string user_id;
+        BigInteger public_key;
+        size_t hash;
+    };
+
+    struct Table {
+        explicit Table(size_t capacity);
+
+        size_t mask;
+        std::unique_ptr<std::atomic<const Entry*>[]> slots;
+    };
+
+    static const Entry* findInTable(const Table& table, const std::string& user_id, size_t hash);
+    static void insertIntoTable(Table& table, const Entry* entry);
+
+    void reserveForInsertion(size_t new_entries_count);
+
+    std::atomic<Table*> table_;
+    std::atomic<size_t> size_{0};
+
+    std::mutex writer_mutex_;
+    std::deque<Entry> entries_;
+    std::vector<std::unique_ptr<Table>> tables_;
+};
+
+template <typename Visitor>
+void PublicKeyRegistry::forEach(Visitor&& visitor) {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+
+    for (const auto& entry : entries_) {
+        visitor(entry.user_id, entry.public_key);
+    }
+}
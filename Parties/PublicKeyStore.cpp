@@ -0,0 +1,241 @@
+#include "PublicKeyStore.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    constexpr char kMagic[8] = {'F', 'S', 'K', 'E', 'Y', 'S', '\0', '\0'};
+    constexpr uint32_t kVersion = 1;
+    constexpr size_t kHeaderSize = 48;
+
+    /// Fixed hash function, so stores stay readable across builds.
+    uint64_t Fnv1aHash(const char* data, size_t size) {
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    uint64_t LoadLittleEndian(const unsigned char* src, size_t bytes) {
+        uint64_t result = 0;
+        for (size_t i = bytes; i > 0; --i) {
+            result = (result << 8) | src[i - 1];
+        }
+        return result;
+    }
+
+    void StoreLittleEndian(unsigned char* dst, uint64_t value, size_t bytes) {
+        for (size_t i = 0; i < bytes; ++i) {
+            dst[i] = static_cast<unsigned char>(value >> (8 * i));
+        }
+    }
+
+    size_t AlignToEight(size_t size) {
+        return (size + 7) & ~size_t(7);
+    }
+
+    bool WriteAll(int fd, const unsigned char* data, size_t size) {
+        while (size > 0) {
+            const ssize_t written = ::write(fd, data, size);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+}  // namespace
+
+PublicKeyStore::PublicKeyStore(const unsigned char* data, size_t data_size, BigInteger module)
+    : data_(data),
+      data_size_(data_size),
+      module_(std::move(module)) {
+    key_width_ = LoadLittleEndian(data_ + 12, 4);
+    id_width_ = LoadLittleEndian(data_ + 16, 4);
+    users_count_ = LoadLittleEndian(data_ + 24, 8);
+    index_capacity_ = LoadLittleEndian(data_ + 32, 8);
+
+    index_ = data_ + AlignToEight(kHeaderSize + key_width_);
+    records_ = index_ + 8 * index_capacity_;
+    record_size_ = 2 + id_width_ + key_width_;
+}
+
+PublicKeyStore::~PublicKeyStore() {
+    munmap(const_cast<unsigned char*>(data_), data_size_);
+}
+
+std::unique_ptr<PublicKeyStore> PublicKeyStore::open(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat file_stat{};
+    if (fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < kHeaderSize) {
+        close(fd);
+        return nullptr;
+    }
+
+    const auto data_size = static_cast<size_t>(file_stat.st_size);
+    void* data = mmap(nullptr, data_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    const uint64_t key_width = LoadLittleEndian(bytes + 12, 4);
+    const uint64_t id_width = LoadLittleEndian(bytes + 16, 4);
+    const uint64_t users_count = LoadLittleEndian(bytes + 24, 8);
+    const uint64_t index_capacity = LoadLittleEndian(bytes + 32, 8);
+
+    const bool is_valid = std::memcmp(bytes, kMagic, sizeof(kMagic)) == 0 &&
+                          LoadLittleEndian(bytes + 8, 4) == kVersion &&
+                          key_width <= data_size && id_width <= UINT16_MAX &&
+                          index_capacity <= data_size / 8 && users_count <= data_size &&
+                          index_capacity > users_count &&
+                          (index_capacity & (index_capacity - 1)) == 0 &&
+                          AlignToEight(kHeaderSize + key_width) + 8 * index_capacity +
+                              users_count * (2 + id_width + key_width) == data_size;
+    auto module = is_valid ? BigInteger::GetFromPackedDigits(bytes + kHeaderSize, key_width)
+                           : std::nullopt;
+    if (!module.has_value()) {
+        munmap(data, data_size);
+        return nullptr;
+    }
+
+    return std::unique_ptr<PublicKeyStore>(new PublicKeyStore(bytes, data_size, std::move(module.value())));
+}
+
+bool PublicKeyStore::write(const std::string& path, const BigInteger& n,
+                           const std::vector<std::pair<std::string, BigInteger>>& users) {
+    const size_t key_width = n.GetPackedDigitsSize();
+
+    size_t id_width = 1;
+    for (const auto& user : users) {
+        if (user.first.size() > UINT16_MAX || user.second.GetPackedDigitsSize() > key_width) {
+            return false;
+        }
+        id_width = std::max(id_width, user.first.size());
+    }
+
+    /// Load factor is at most 1/2
+    uint64_t index_capacity = 2;
+    while (index_capacity < 2 * users.size()) {
+        index_capacity *= 2;
+    }
+
+    const size_t index_offset = AlignToEight(kHeaderSize + key_width);
+    const size_t records_offset = index_offset + 8 * index_capacity;
+    const size_t record_size = 2 + id_width + key_width;
+    std::vector<unsigned char> data(records_offset + users.size() * record_size, 0);
+
+    std::memcpy(data.data(), kMagic, sizeof(kMagic));
+    StoreLittleEndian(data.data() + 8, kVersion, 4);
+    StoreLittleEndian(data.data() + 12, key_width, 4);
+    StoreLittleEndian(data.data() + 16, id_width, 4);
+    StoreLittleEndian(data.data() + 24, users.size(), 8);
+    StoreLittleEndian(data.data() + 32, index_capacity, 8);
+    n.WritePackedDigits(data.data() + kHeaderSize, key_width);
+
+    for (size_t record = 0; record < users.size(); ++record) {
+        const auto& [user_id, public_key] = users[record];
+        unsigned char* dst = data.data() + records_offset + record * record_size;
+
+        StoreLittleEndian(dst, user_id.size(), 2);
+        std::memcpy(dst + 2, user_id.data(), user_id.size());
+        public_key.WritePackedDigits(dst + 2 + id_width, key_width);
+
+        uint64_t slot = Fnv1aHash(user_id.data(), user_id.size()) & (index_capacity - 1);
+        while (LoadLittleEndian(data.data() + index_offset + 8 * slot, 8) != 0) {
+            slot = (slot + 1) & (index_capacity - 1);
+        }
+        StoreLittleEndian(data.data() + index_offset + 8 * slot, record + 1, 8);
+    }
+
+    /// Truncating path would pull the pages from under a live mapping of it (SIGBUS or a torn
+    /// header for the reader), while rename swaps the inode and leaves old mappings intact.
+    const std::string temporary_path = path + ".tmp";
+    const int fd = ::open(temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    const bool is_written = WriteAll(fd, data.data(), data.size()) && fsync(fd) == 0;
+    if (close(fd) != 0 || !is_written || std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+        std::remove(temporary_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+BigInteger PublicKeyStore::getModule() const {
+    return module_;
+}
+
+bool PublicKeyStore::contains(const std::string& user_id) const {
+    return findRecord(user_id).has_value();
+}
+
+std::optional<BigInteger> PublicKeyStore::find(const std::string& user_id) const {
+    const auto record = findRecord(user_id);
+
+    if (!record.has_value()) {
+        return std::nullopt;
+    }
+
+    return getRecordPublicKey(record.value());
+}
+
+size_t PublicKeyStore::size() const {
+    return users_count_;
+}
+
+std::optional<uint64_t> PublicKeyStore::findRecord(const std::string& user_id) const {
+    if (user_id.size() > id_width_) {
+        return std::nullopt;
+    }
+
+    const uint64_t mask = index_capacity_ - 1;
+    uint64_t slot = Fnv1aHash(user_id.data(), user_id.size()) & mask;
+    for (uint64_t probes = 0; probes < index_capacity_; ++probes, slot = (slot + 1) & mask) {
+        const uint64_t value = LoadLittleEndian(index_ + 8 * slot, 8);
+
+        if (value == 0 || value > users_count_) {
+            return std::nullopt;
+        }
+
+        const unsigned char* record = records_ + (value - 1) * record_size_;
+        if (LoadLittleEndian(record, 2) == user_id.size() &&
+            std::memcmp(record + 2, user_id.data(), user_id.size()) == 0) {
+            return value - 1;
+        }
+    }
+    return std::nullopt;
+}
+
+std::string PublicKeyStore::getRecordUserId(uint64_t record) const {
+    const unsigned char* src = records_ + record * record_size_;
+    const size_t length = std::min<size_t>(LoadLittleEndian(src, 2), id_width_);
+
+    return std::string(reinterpret_cast<const char*>(src + 2), length);
+}
+
+std::optional<BigInteger> PublicKeyStore::getRecordPublicKey(uint64_t record) const {
+    const unsigned char* src = records_ + record * record_size_ + 2 + id_width_;
+
+    return BigInteger::GetFromPackedDigits(src, key_width_);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "big_integer.h"
+
+/// Read-only memory-mapped file of registered public keys.
+///
+/// Layout, all integers are little-endian:
+///   header   magic "FSKEYS", version, key width, id width, users count, index capacity
+///   module   N as packed decimal digits, key width bytes
+///   index    index capacity x uint64: record number + 1, or 0 for an empty slot
+///   records  users count x (uint16 id length, id padded to id width, key as packed decimal digits)
+/// The index is an open-addressing table keyed by the FNV-1a hash of the user id,
+/// so opening a store doesn't parse or allocate anything per user; a corrupt record
+/// is only noticed when it's decoded.
+class PublicKeyStore {
+  public:
+    ~PublicKeyStore();
+
+    PublicKeyStore(const PublicKeyStore&) = delete;
+    PublicKeyStore& operator = (const PublicKeyStore&) = delete;
+
+    /// Returns nullptr if the file can't be mapped or isn't a valid store.
+    static std::unique_ptr<PublicKeyStore> open(const std::string& path);
+
+    /// Writes path + ".tmp", syncs it and renames it over path, so a store mapped by
+    /// open is never modified in place and readers see either the old or the new file.
+    /// Returns false on I/O errors.
+    static bool write(const std::string& path, const BigInteger& n,
+                      const std::vector<std::pair<std::string, BigInteger>>& users);
+
+    BigInteger getModule() const;
+
+    bool contains(const std::string& user_id) const;
+
+    /// Decodes the key straight from the mapping.
+    /// Returns std::nullopt if the user isn't stored or the stored key is corrupt.
+    std::optional<BigInteger> find(const std::string& user_id) const;
+
+    size_t size() const;
+
+    /// Calls visitor(user_id, public_key) for every stored user whose key decodes.
+    template <typename Visitor>
+    void forEach(Visitor&& visitor) const;
+
+  private:
+    PublicKeyStore(const unsigned char* data, size_t data_size, BigInteger module);
+
+    /// Returns std::nullopt if the user isn't stored.
+    /// Probes at most index capacity slots, so a corrupt index without empty slots can't loop.
+    std::optional<uint64_t> findRecord(const std::string& user_id) const;
+
+    std::string getRecordUserId(uint64_t record) const;
+    /// Returns std::nullopt if the packed digits are corrupt.
+    std::optional<BigInteger> getRecordPublicKey(uint64_t record) const;
+
+    const unsigned char* data_;
+    size_t data_size_;
+
+    /// Decoded and checked by open
+    BigInteger module_;
+
+    size_t key_width_;
+    size_t id_width_;
+    uint64_t users_count_;
+    uint64_t index_capacity_;
+
+    const unsigned char* index_;
+    const unsigned char* records_;
+    size_t record_size_;
+};
+
+template <typename Visitor>
+void PublicKeyStore::forEach(Visitor&& visitor) const {
+    for (uint64_t record = 0; record < users_count_; ++record) {
+        auto public_key = getRecordPublicKey(record);
+        if (public_key.has_value()) {
+            visitor(getRecordUserId(record), std::move(public_key.value()));
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ThreadPool {
+  public:
+    explicit ThreadPool(size_t threads_count = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator = (const ThreadPool&) = delete;
+
+    size_t size() const;
+
+    template <typename Task>
+    std::future<std::invoke_result_t<Task>> submit(Task&& task);
+
+  private:
+    void workerLoop();
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable has_tasks_;
+    bool is_stopping_{false};
+};
+
+template <typename Task>
+std::future<std::invoke_result_t<Task>> ThreadPool::submit(Task&& task) {
+    using Result = std::invoke_result_t<Task>;
+
+    auto packaged_task = std::make_shared<std::packaged_task<Result()>>(std::forward<Task>(task));
+    std::future<Result> result = packaged_task->get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.emplace([packaged_task]() { (*packaged_task)(); });
+    }
+    has_tasks_.notify_one();
+
+    return result;
+}
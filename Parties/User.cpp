@@ -5,6 +5,8 @@
 #include "User.h"
 
 #include "crypto_algorithms.h"
+#include "instrumentation.h"
+#include "tracing.h"
 
 
 User::User(const std::string& user_id, const BigInteger& n) {
@@ -33,12 +35,16 @@ const std::string& User::getUserId() const {
 }
 
 BigInteger User::initAuthentication() {
-    r_ = Crypto::GetRandomNumber(1, n_ - 1);
+    FS_LATENCY_SCOPE("user_init_authentication_seconds");
+    FS_TRACE_SPAN("User::initAuthentication");
+    r_ = Crypto::GetSecureRandomNumber(1, n_ - 1);
 
     return (r_.value() * r_.value()) % n_;
 }
 
 std::optional<BigInteger> User::processChallenge(bool e) {
+    FS_LATENCY_SCOPE("user_process_challenge_seconds");
+    FS_TRACE_SPAN("User::processChallenge");
     if (!r_.has_value()) {
         return std::nullopt;
     }
@@ -50,3 +56,38 @@ std::optional<BigInteger> User::processChallenge(bool e) {
 
     return result;
 }
+
+std::vector<BigInteger> User::initAuthentication(uint32_t rounds_count) {
+    FS_LATENCY_SCOPE("user_init_authentication_pipelined_seconds");
+    FS_TRACE_SPAN("User::initAuthentication(pipelined)");
+    pipelined_r_.clear();
+    pipelined_r_.reserve(rounds_count);
+
+    std::vector<BigInteger> result;
+    result.reserve(rounds_count);
+    for (uint32_t i = 0; i < rounds_count; ++i) {
+        pipelined_r_.push_back(Crypto::GetSecureRandomNumber(1, n_ - 1));
+        result.push_back((pipelined_r_.back() * pipelined_r_.back()) % n_);
+    }
+
+    return result;
+}
+
+std::optional<std::vector<BigInteger>> User::processChallenges(const std::vector<bool>& challenges) {
+    FS_LATENCY_SCOPE("user_process_challenges_pipelined_seconds");
+    FS_TRACE_SPAN("User::processChallenges");
+    if (pipelined_r_.empty() || challenges.size() != pipelined_r_.size()) {
+        return std::nullopt;
+    }
+
+    std::vector<BigInteger> result;
+    result.reserve(challenges.size());
+    for (size_t i = 0; i < challenges.size(); ++i) {
+        result.push_back(challenges[i] ? (pipelined_r_[i] * private_key_) % n_
+                                       : std::move(pipelined_r_[i]));
+    }
+
+    pipelined_r_.clear();
+
+    return result;
+}
@@ -6,6 +6,7 @@
 
 #include <string>
 #include <optional>
+#include <vector>
 
 #include "big_integer.h"
 
@@ -17,10 +18,18 @@ class User {
 
     const std::string& getUserId() const;
 
+    /// r comes from the kernel CSPRNG, so provers may run on any number of threads.
     BigInteger initAuthentication();
 
     std::optional<BigInteger> processChallenge(bool e);
 
+    /// Pipelined mode: all t commitments are sent at once.
+    std::vector<BigInteger> initAuthentication(uint32_t rounds_count);
+
+    /// Answers the challenges for the commitments of the last pipelined initAuthentication.
+    /// Returns std::nullopt if there are no such commitments or the number of challenges differs.
+    std::optional<std::vector<BigInteger>> processChallenges(const std::vector<bool>& challenges);
+
   private:
     BigInteger n_;
 
@@ -30,4 +39,5 @@ class User {
 
     // Authentication
     std::optional<BigInteger> r_;
+    std::vector<BigInteger> pipelined_r_;
 };
@@ -0,0 +1,198 @@
+#include "VerifierService.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "crypto_algorithms.h"
+#include "tracing.h"
+
+VerifierService::VerifierService(const CentralAuthority& ca, uint32_t rounds_count,
+                                 size_t shards_count, Clock::duration session_timeout)
+    : ca_(ca),
+      rounds_count_(rounds_count),
+      session_timeout_(session_timeout) {
+    shards_.reserve(std::max<size_t>(shards_count, 1));
+    for (size_t i = 0; i < std::max<size_t>(shards_count, 1); ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+        shards_.back()->last_sweep = Clock::now();
+    }
+}
+
+std::optional<SessionId> VerifierService::beginSession(const std::string& user_id) {
+    FS_TRACE_SPAN("VerifierService::beginSession");
+    const BigInteger* public_key = ca_.getUserPublicKey(user_id);
+
+    if (public_key == nullptr) {
+        return std::nullopt;
+    }
+
+    const SessionId session_id = next_session_id_.fetch_add(1, std::memory_order_relaxed);
+    const auto now = Clock::now();
+
+    Shard& shard = getShard(session_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    sweepExpiredSessions(shard, now);
+
+    Session& session = shard.sessions[session_id];
+    session.public_key = public_key;
+    session.last_activity = now;
+
+    return session_id;
+}
+
+std::optional<bool> VerifierService::submitCommitment(SessionId session_id, const BigInteger& commitment) {
+    FS_TRACE_SPAN("VerifierService::submitCommitment");
+    const auto now = Clock::now();
+    Shard& shard = getShard(session_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    Session* session = findSession(shard, session_id, now);
+    if (session == nullptr || session->commitment.has_value() || !session->commitments.empty()) {
+        return std::nullopt;
+    }
+
+    session->commitment = commitment;
+    session->challenge = nextChallenge(shard);
+    session->last_activity = now;
+
+    return session->challenge;
+}
+
+RoundResult VerifierService::submitResponse(SessionId session_id, const BigInteger& response) {
+    FS_TRACE_SPAN("VerifierService::submitResponse");
+    const auto now = Clock::now();
+    Shard& shard = getShard(session_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    Session* session = findSession(shard, session_id, now);
+    if (session == nullptr) {
+        return RoundResult::UNKNOWN_SESSION;
+    }
+
+    if (!session->commitment.has_value() ||
+        !ca_.verifyRound(*session->public_key, session->commitment.value(), session->challenge, response)) {
+        shard.sessions.erase(session_id);
+        return RoundResult::REJECTED;
+    }
+
+    session->commitment.reset();
+    session->last_activity = now;
+    if (++session->rounds_passed < rounds_count_) {
+        return RoundResult::CONTINUE;
+    }
+
+    shard.sessions.erase(session_id);
+    return RoundResult::ACCEPTED;
+}
+
+std::optional<std::vector<bool>> VerifierService::submitCommitments(SessionId session_id,
+                                                                    std::vector<BigInteger> commitments) {
+    FS_TRACE_SPAN("VerifierService::submitCommitments");
+    const auto now = Clock::now();
+    Shard& shard = getShard(session_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    Session* session = findSession(shard, session_id, now);
+    if (session == nullptr || session->commitment.has_value() || session->rounds_passed != 0 ||
+        !session->commitments.empty() || commitments.size() != rounds_count_ || commitments.empty()) {
+        return std::nullopt;
+    }
+
+    session->commitments = std::move(commitments);
+    session->challenges.resize(session->commitments.size());
+    for (size_t i = 0; i < session->challenges.size(); ++i) {
+        session->challenges[i] = nextChallenge(shard);
+    }
+    session->last_activity = now;
+
+    return session->challenges;
+}
+
+RoundResult VerifierService::submitResponses(SessionId session_id, const std::vector<BigInteger>& responses) {
+    FS_TRACE_SPAN("VerifierService::submitResponses");
+    Session session;
+    {
+        const auto now = Clock::now();
+        Shard& shard = getShard(session_id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        Session* found_session = findSession(shard, session_id, now);
+        if (found_session == nullptr) {
+            return RoundResult::UNKNOWN_SESSION;
+        }
+        session = std::move(*found_session);
+        shard.sessions.erase(session_id);
+    }
+
+    if (session.commitments.empty() || responses.size() != session.commitments.size()) {
+        return RoundResult::REJECTED;
+    }
+    for (size_t i = 0; i < responses.size(); ++i) {
+        if (!ca_.verifyRound(*session.public_key, session.commitments[i], session.challenges[i], responses[i])) {
+            return RoundResult::REJECTED;
+        }
+    }
+    return RoundResult::ACCEPTED;
+}
+
+void VerifierService::endSession(SessionId session_id) {
+    Shard& shard = getShard(session_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    shard.sessions.erase(session_id);
+}
+
+uint32_t VerifierService::getRoundsCount() const {
+    return rounds_count_;
+}
+
+size_t VerifierService::getActiveSessionsCount() const {
+    size_t result = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        result += shard->sessions.size();
+    }
+    return result;
+}
+
+VerifierService::Shard& VerifierService::getShard(SessionId session_id) {
+    return *shards_[session_id % shards_.size()];
+}
+
+VerifierService::Session* VerifierService::findSession(Shard& shard, SessionId session_id,
+                                                       Clock::time_point now) {
+    const auto session_it = shard.sessions.find(session_id);
+    if (session_it == shard.sessions.end()) {
+        return nullptr;
+    }
+    if (now - session_it->second.last_activity > session_timeout_) {
+        shard.sessions.erase(session_it);
+        return nullptr;
+    }
+    return &session_it->second;
+}
+
+void VerifierService::sweepExpiredSessions(Shard& shard, Clock::time_point now) {
+    if (now - shard.last_sweep < session_timeout_ / 2) {
+        return;
+    }
+    shard.last_sweep = now;
+    for (auto session_it = shard.sessions.begin(); session_it != shard.sessions.end(); ) {
+        if (now - session_it->second.last_activity > session_timeout_) {
+            session_it = shard.sessions.erase(session_it);
+        } else {
+            ++session_it;
+        }
+    }
+}
+
+bool VerifierService::nextChallenge(Shard& shard) {
+    if (shard.random_bits_left == 0) {
+        Crypto::GetSecureRandomBytes(&shard.random_bits, sizeof(shard.random_bits));
+        shard.random_bits_left = 64;
+    }
+    const bool bit = shard.random_bits & 1;
+    shard.random_bits >>= 1;
+    --shard.random_bits_left;
+    return bit;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "big_integer.h"
+
+#include "CentralAuthority.h"
+
+using SessionId = uint64_t;
+
+enum class RoundResult {
+    CONTINUE,
+    ACCEPTED,
+    REJECTED,
+    UNKNOWN_SESSION
+};
+
+/// Verifier side of the protocol for many concurrent provers.
+/// Sessions live in a sharded hash table, so calls for different sessions rarely contend.
+/// A session idle for longer than session_timeout is dropped, so abandoned sessions
+/// don't accumulate. Challenges come from the kernel CSPRNG.
+/// All public methods are thread-safe: any number of caller threads may share one service.
+/// The checks run on the calling thread; the service starts no threads of its own.
+class VerifierService {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit VerifierService(const CentralAuthority& ca,
+                             uint32_t rounds_count = 30,
+                             size_t shards_count = 64,
+                             Clock::duration session_timeout = std::chrono::seconds(60));
+
+    /// Returns std::nullopt if the user isn't registered.
+    std::optional<SessionId> beginSession(const std::string& user_id);
+
+    /// Stores commitment x and returns challenge e.
+    /// Returns std::nullopt if the session doesn't exist or already waits for a response.
+    std::optional<bool> submitCommitment(SessionId session_id, const BigInteger& commitment);
+
+    /// Checks response y for the pending challenge.
+    /// The session is closed once it is accepted or rejected.
+    RoundResult submitResponse(SessionId session_id, const BigInteger& response);
+
+    /// Pipelined mode: stores all rounds_count commitments of a fresh session at once
+    /// and returns their challenges.
+    /// Returns std::nullopt if the session doesn't exist, already started or the count differs.
+    std::optional<std::vector<bool>> submitCommitments(SessionId session_id,
+                                                       std::vector<BigInteger> commitments);
+
+    /// Checks the responses to the challenges of submitCommitments; never returns CONTINUE.
+    /// The session is closed either way, and the check runs after its shard is unlocked.
+    RoundResult submitResponses(SessionId session_id, const std::vector<BigInteger>& responses);
+
+    /// Drops an unfinished session, e.g. when its prover disconnects.
+    void endSession(SessionId session_id);
+
+    uint32_t getRoundsCount() const;
+
+    /// Includes sessions that have expired but weren't swept yet.
+    size_t getActiveSessionsCount() const;
+
+  private:
+    struct Session {
+        const BigInteger* public_key{nullptr};
+        std::optional<BigInteger> commitment;
+        bool challenge{false};
+        uint32_t rounds_passed{0};
+        /// Pipelined mode
+        std::vector<BigInteger> commitments;
+        std::vector<bool> challenges;
+        Clock::time_point last_activity;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<SessionId, Session> sessions;
+        Clock::time_point last_sweep;
+        /// Challenge bits fetched from the CSPRNG 64 at a time
+        uint64_t random_bits{0};
+        int random_bits_left{0};
+    };
+
+    Shard& getShard(SessionId session_id);
+
+    /// Returns the live session or nullptr; an expired one is erased on the way.
+    /// REQUIREMENT: shard.mutex is held
+    Session* findSession(Shard& shard, SessionId session_id, Clock::time_point now);
+    /// Erases expired sessions at most once per half timeout, so the cost is amortized.
+    /// REQUIREMENT: shard.mutex is held
+    void sweepExpiredSessions(Shard& shard, Clock::time_point now);
+    /// REQUIREMENT: shard.mutex is held
+    static bool nextChallenge(Shard& shard);
+
+    const CentralAuthority& ca_;
+    const uint32_t rounds_count_;
+    const Clock::duration session_timeout_;
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<SessionId> next_session_id_{1};
+};
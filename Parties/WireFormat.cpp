@@ -0,0 +1,407 @@
+#include "WireFormat.h"
+
+namespace Wire {
+
+namespace {
+    constexpr size_t kFrameHeaderSize = 5;
+
+    /// Sequential reader of one payload.
+    class PayloadReader {
+      public:
+        explicit PayloadReader(const Message& message)
+            : data_(message.payload),
+              size_(message.size) {
+        }
+
+        std::optional<uint64_t> readUint(size_t bytes) {
+            if (size_ - position_ < bytes) {
+                return std::nullopt;
+            }
+            uint64_t result = 0;
+            for (size_t i = bytes; i > 0; --i) {
+                result = (result << 8) | data_[position_ + i - 1];
+            }
+            position_ += bytes;
+            return result;
+        }
+
+        std::optional<BigInteger> readBigInteger() {
+            const auto sign = readUint(1);
+            const auto packed_size = readUint(4);
+            if (!sign.has_value() || !packed_size.has_value() || sign.value() > 1 ||
+                size_ - position_ < packed_size.value()) {
+                return std::nullopt;
+            }
+
+            auto result = BigInteger::GetFromPackedDigits(data_ + position_, packed_size.value());
+            position_ += packed_size.value();
+            if (result.has_value() && sign.value() == 1) {
+                result.value() *= -1;
+            }
+            return result;
+        }
+
+        std::optional<std::vector<BigInteger>> readBigIntegers() {
+            const auto count = readUint(4);
+            if (!count.has_value()) {
+                return std::nullopt;
+            }
+
+            std::vector<BigInteger> result;
+            for (uint64_t i = 0; i < count.value(); ++i) {
+                auto number = readBigInteger();
+                if (!number.has_value()) {
+                    return std::nullopt;
+                }
+                result.push_back(std::move(number.value()));
+            }
+            return result;
+        }
+
+        std::optional<std::vector<bool>> readBits() {
+            const auto count = readUint(4);
+            if (!count.has_value() || (size_ - position_) * 8 < count.value()) {
+                return std::nullopt;
+            }
+
+            std::vector<bool> result(count.value());
+            for (size_t i = 0; i < result.size(); ++i) {
+                result[i] = (data_[position_ + i / 8] >> (i % 8)) & 1;
+            }
+            position_ += (count.value() + 7) / 8;
+            return result;
+        }
+
+        std::optional<std::string> readString() {
+            const auto length = readUint(2);
+            if (!length.has_value() || size_ - position_ < length.value()) {
+                return std::nullopt;
+            }
+
+            std::string result(reinterpret_cast<const char*>(data_ + position_), length.value());
+            position_ += length.value();
+            return result;
+        }
+
+        bool isAtEnd() const {
+            return position_ == size_;
+        }
+
+      private:
+        const unsigned char* data_;
+        size_t size_;
+        size_t position_{0};
+    };
+
+    std::optional<BigInteger> DecodeSingleBigInteger(const Message& message, MessageType type) {
+        if (message.type != type) {
+            return std::nullopt;
+        }
+
+        PayloadReader reader(message);
+        auto result = reader.readBigInteger();
+        if (!reader.isAtEnd()) {
+            return std::nullopt;
+        }
+        return result;
+    }
+
+    std::optional<std::vector<BigInteger>> DecodeBigIntegers(const Message& message, MessageType type) {
+        if (message.type != type) {
+            return std::nullopt;
+        }
+
+        PayloadReader reader(message);
+        auto result = reader.readBigIntegers();
+        if (!reader.isAtEnd()) {
+            return std::nullopt;
+        }
+        return result;
+    }
+}  // namespace
+
+void Writer::writeCommitment(const BigInteger& commitment) {
+    const size_t message_begin = beginMessage(MessageType::COMMITMENT);
+    writeBigInteger(commitment);
+    endMessage(message_begin);
+}
+
+void Writer::writeChallenge(const std::vector<bool>& challenges) {
+    const size_t message_begin = beginMessage(MessageType::CHALLENGE);
+    writeBits(challenges);
+    endMessage(message_begin);
+}
+
+void Writer::writeResponse(const BigInteger& response) {
+    const size_t message_begin = beginMessage(MessageType::RESPONSE);
+    writeBigInteger(response);
+    endMessage(message_begin);
+}
+
+void Writer::writeCommitments(const std::vector<BigInteger>& commitments) {
+    const size_t message_begin = beginMessage(MessageType::COMMITMENTS);
+    writeBigIntegers(commitments);
+    endMessage(message_begin);
+}
+
+void Writer::writeResponses(const std::vector<BigInteger>& responses) {
+    const size_t message_begin = beginMessage(MessageType::RESPONSES);
+    writeBigIntegers(responses);
+    endMessage(message_begin);
+}
+
+void Writer::writeProof(const Proof& proof) {
+    const size_t message_begin = beginMessage(MessageType::PROOF);
+
+    writeString(proof.user_id);
+    writeBigIntegers(proof.commitments);
+    writeBits(proof.challenges);
+    writeBigIntegers(proof.responses);
+
+    endMessage(message_begin);
+}
+
+void Writer::writeModuleRequest() {
+    endMessage(beginMessage(MessageType::MODULE_REQUEST));
+}
+
+void Writer::writeModule(const BigInteger& n) {
+    const size_t message_begin = beginMessage(MessageType::MODULE);
+    writeBigInteger(n);
+    endMessage(message_begin);
+}
+
+void Writer::writeRegister(const std::string& user_id, const BigInteger& public_key) {
+    const size_t message_begin = beginMessage(MessageType::REGISTER);
+    writeString(user_id);
+    writeBigInteger(public_key);
+    endMessage(message_begin);
+}
+
+void Writer::writeBeginSession(const std::string& user_id) {
+    const size_t message_begin = beginMessage(MessageType::BEGIN_SESSION);
+    writeString(user_id);
+    endMessage(message_begin);
+}
+
+void Writer::writeStatus(Status status) {
+    const size_t message_begin = beginMessage(MessageType::STATUS);
+    writeUint(static_cast<uint8_t>(status), 1);
+    endMessage(message_begin);
+}
+
+const std::vector<unsigned char>& Writer::data() const {
+    return buffer_;
+}
+
+void Writer::clear() {
+    buffer_.clear();
+}
+
+size_t Writer::beginMessage(MessageType type) {
+    const size_t message_begin = buffer_.size();
+    buffer_.resize(message_begin + kFrameHeaderSize);
+    buffer_[message_begin] = static_cast<unsigned char>(type);
+    return message_begin;
+}
+
+void Writer::endMessage(size_t message_begin) {
+    const uint64_t payload_size = buffer_.size() - message_begin - kFrameHeaderSize;
+    for (size_t i = 0; i < 4; ++i) {
+        buffer_[message_begin + 1 + i] = static_cast<unsigned char>(payload_size >> (8 * i));
+    }
+}
+
+void Writer::writeUint(uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        buffer_.push_back(static_cast<unsigned char>(value >> (8 * i)));
+    }
+}
+
+void Writer::writeBigInteger(const BigInteger& number) {
+    const size_t packed_size = number.GetPackedDigitsSize();
+
+    writeUint(number.IsPositive() ? 0 : 1, 1);
+    writeUint(packed_size, 4);
+
+    const size_t position = buffer_.size();
+    buffer_.resize(position + packed_size);
+    number.WritePackedDigits(buffer_.data() + position, packed_size);
+}
+
+void Writer::writeBigIntegers(const std::vector<BigInteger>& numbers) {
+    writeUint(numbers.size(), 4);
+    for (const auto& number : numbers) {
+        writeBigInteger(number);
+    }
+}
+
+void Writer::writeBits(const std::vector<bool>& bits) {
+    writeUint(bits.size(), 4);
+
+    const size_t position = buffer_.size();
+    buffer_.resize(position + (bits.size() + 7) / 8, 0);
+    for (size_t i = 0; i < bits.size(); ++i) {
+        if (bits[i]) {
+            buffer_[position + i / 8] |= static_cast<unsigned char>(1 << (i % 8));
+        }
+    }
+}
+
+void Writer::writeString(const std::string& str) {
+    writeUint(str.size(), 2);
+    buffer_.insert(buffer_.end(), str.begin(), str.end());
+}
+
+Reader::Reader(const unsigned char* data, size_t size)
+    : data_(data),
+      size_(size) {
+}
+
+Reader::Reader(const std::vector<unsigned char>& data)
+    : Reader(data.data(), data.size()) {
+}
+
+std::optional<Message> Reader::next() {
+    if (size_ - position_ < kFrameHeaderSize) {
+        return std::nullopt;
+    }
+
+    size_t payload_size = 0;
+    for (size_t i = 4; i > 0; --i) {
+        payload_size = (payload_size << 8) | data_[position_ + i];
+    }
+    if (size_ - position_ - kFrameHeaderSize < payload_size) {
+        return std::nullopt;
+    }
+
+    Message result{static_cast<MessageType>(data_[position_]),
+                   data_ + position_ + kFrameHeaderSize,
+                   payload_size};
+    position_ += kFrameHeaderSize + payload_size;
+    return result;
+}
+
+bool Reader::isAtEnd() const {
+    return position_ == size_;
+}
+
+size_t Reader::getPosition() const {
+    return position_;
+}
+
+std::optional<BigInteger> DecodeCommitment(const Message& message) {
+    return DecodeSingleBigInteger(message, MessageType::COMMITMENT);
+}
+
+std::optional<std::vector<bool>> DecodeChallenge(const Message& message) {
+    if (message.type != MessageType::CHALLENGE) {
+        return std::nullopt;
+    }
+
+    PayloadReader reader(message);
+    auto result = reader.readBits();
+    if (!reader.isAtEnd()) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+std::optional<BigInteger> DecodeResponse(const Message& message) {
+    return DecodeSingleBigInteger(message, MessageType::RESPONSE);
+}
+
+std::optional<std::vector<BigInteger>> DecodeCommitments(const Message& message) {
+    return DecodeBigIntegers(message, MessageType::COMMITMENTS);
+}
+
+std::optional<std::vector<BigInteger>> DecodeResponses(const Message& message) {
+    return DecodeBigIntegers(message, MessageType::RESPONSES);
+}
+
+std::optional<Proof> DecodeProof(const Message& message) {
+    if (message.type != MessageType::PROOF) {
+        return std::nullopt;
+    }
+
+    PayloadReader reader(message);
+    Proof result;
+
+    auto user_id = reader.readString();
+    if (!user_id.has_value()) {
+        return std::nullopt;
+    }
+    result.user_id = std::move(user_id.value());
+
+    auto commitments = reader.readBigIntegers();
+    if (!commitments.has_value()) {
+        return std::nullopt;
+    }
+    result.commitments = std::move(commitments.value());
+
+    auto challenges = reader.readBits();
+    if (!challenges.has_value()) {
+        return std::nullopt;
+    }
+    result.challenges = std::move(challenges.value());
+
+    auto responses = reader.readBigIntegers();
+    if (!responses.has_value()) {
+        return std::nullopt;
+    }
+    result.responses = std::move(responses.value());
+
+    if (!reader.isAtEnd() ||
+        result.challenges.size() != result.commitments.size() ||
+        result.responses.size() != result.commitments.size()) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+std::optional<BigInteger> DecodeModule(const Message& message) {
+    return DecodeSingleBigInteger(message, MessageType::MODULE);
+}
+
+std::optional<std::pair<std::string, BigInteger>> DecodeRegister(const Message& message) {
+    if (message.type != MessageType::REGISTER) {
+        return std::nullopt;
+    }
+
+    PayloadReader reader(message);
+    auto user_id = reader.readString();
+    auto public_key = reader.readBigInteger();
+    if (!user_id.has_value() || !public_key.has_value() || !reader.isAtEnd()) {
+        return std::nullopt;
+    }
+    return std::make_pair(std::move(user_id.value()), std::move(public_key.value()));
+}
+
+std::optional<std::string> DecodeBeginSession(const Message& message) {
+    if (message.type != MessageType::BEGIN_SESSION) {
+        return std::nullopt;
+    }
+
+    PayloadReader reader(message);
+    auto result = reader.readString();
+    if (!reader.isAtEnd()) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+std::optional<Status> DecodeStatus(const Message& message) {
+    if (message.type != MessageType::STATUS) {
+        return std::nullopt;
+    }
+
+    PayloadReader reader(message);
+    const auto status = reader.readUint(1);
+    if (!status.has_value() || !reader.isAtEnd() ||
+        status.value() > static_cast<uint8_t>(Status::FAILED)) {
+        return std::nullopt;
+    }
+    return static_cast<Status>(status.value());
+}
+
+}  // namespace Wire
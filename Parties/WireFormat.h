@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "big_integer.h"
+
+/// Binary encoding of protocol messages.
+///
+/// Every message is a frame: uint8 type, uint32 payload size, payload.
+/// All integers are little-endian. A BigInteger is encoded as uint8 sign (1 for negative),
+/// uint32 size and its packed decimal digits, which map one-to-one onto BigInteger digits,
+/// so decoding is a single pass without radix conversion.
+/// Any number of frames can be appended to one buffer.
+namespace Wire {
+
+enum class MessageType : uint8_t {
+    COMMITMENT = 1,
+    CHALLENGE = 2,
+    RESPONSE = 3,
+    PROOF = 4,
+    MODULE_REQUEST = 5,
+    MODULE = 6,
+    REGISTER = 7,
+    BEGIN_SESSION = 8,
+    STATUS = 9,
+    /// Pipelined mode: all t commitments, answered by one CHALLENGE with t bits, then all t responses
+    COMMITMENTS = 10,
+    RESPONSES = 11
+};
+
+enum class Status : uint8_t {
+    OK = 0,
+    CONTINUE = 1,
+    ACCEPTED = 2,
+    REJECTED = 3,
+    FAILED = 4
+};
+
+/// Transcript of t rounds, e.g. a non-interactive proof.
+struct Proof {
+    std::string user_id;
+    std::vector<BigInteger> commitments;
+    std::vector<bool> challenges;
+    std::vector<BigInteger> responses;
+};
+
+class Writer {
+  public:
+    void writeCommitment(const BigInteger& commitment);
+    void writeChallenge(const std::vector<bool>& challenges);
+    void writeResponse(const BigInteger& response);
+    void writeCommitments(const std::vector<BigInteger>& commitments);
+    void writeResponses(const std::vector<BigInteger>& responses);
+    void writeProof(const Proof& proof);
+    void writeModuleRequest();
+    void writeModule(const BigInteger& n);
+    void writeRegister(const std::string& user_id, const BigInteger& public_key);
+    void writeBeginSession(const std::string& user_id);
+    void writeStatus(Status status);
+
+    const std::vector<unsigned char>& data() const;
+    void clear();
+
+  private:
+    size_t beginMessage(MessageType type);
+    void endMessage(size_t message_begin);
+
+    void writeUint(uint64_t value, size_t bytes);
+    void writeBigInteger(const BigInteger& number);
+    /// uint32 count, then the numbers
+    void writeBigIntegers(const std::vector<BigInteger>& numbers);
+    void writeBits(const std::vector<bool>& bits);
+    void writeString(const std::string& str);
+
+    std::vector<unsigned char> buffer_;
+};
+
+struct Message {
+    MessageType type;
+    const unsigned char* payload;
+    size_t size;
+};
+
+/// Doesn't own the buffer.
+class Reader {
+  public:
+    Reader(const unsigned char* data, size_t size);
+    explicit Reader(const std::vector<unsigned char>& data);
+
+    /// Returns std::nullopt at the end of the buffer or if the next frame is truncated.
+    std::optional<Message> next();
+
+    bool isAtEnd() const;
+
+    /// Bytes taken by the frames returned so far.
+    size_t getPosition() const;
+
+  private:
+    const unsigned char* data_;
+    size_t size_;
+    size_t position_{0};
+};
+
+/// Decoders return std::nullopt if the message has another type or is malformed.
+std::optional<BigInteger> DecodeCommitment(const Message& message);
+std::optional<std::vector<bool>> DecodeChallenge(const Message& message);
+std::optional<BigInteger> DecodeResponse(const Message& message);
+std::optional<std::vector<BigInteger>> DecodeCommitments(const Message& message);
+std::optional<std::vector<BigInteger>> DecodeResponses(const Message& message);
+std::optional<Proof> DecodeProof(const Message& message);
+std::optional<BigInteger> DecodeModule(const Message& message);
+std::optional<std::pair<std::string, BigInteger>> DecodeRegister(const Message& message);
+std::optional<std::string> DecodeBeginSession(const Message& message);
+std::optional<Status> DecodeStatus(const Message& message);
+
+}  // namespace Wire
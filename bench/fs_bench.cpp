@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CentralAuthority.h"
+#include "User.h"
+#include "VerifierService.h"
+
+#include "crypto_algorithms.h"
+#include "instrumentation.h"
+#include "tracing.h"
+
+
+/// Load generator for the whole protocol: provers and VerifierService in one process.
+/// Every thread keeps its share of sessions in flight and advances them round-robin,
+/// one protocol step at a time.
+
+struct Options {
+    int modulus_bitness = 64;
+    uint32_t rounds = 30;
+    int users = 16;
+    int concurrent_sessions = 64;
+    int authentications = 2000;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    /// "json" or "prometheus": dump of the instrumentation after the run.
+    std::string metrics_format;
+    /// Chrome trace of the run is written here if set.
+    std::string trace_path;
+    /// If set, the users are saved to a key store at this path and verified against
+    /// the mapped store, so every user's first lookup decodes its key (cold store).
+    std::string key_store_path;
+};
+
+struct ThreadStats {
+    std::vector<double> latencies_us;
+    double prover_cpu_seconds = 0;
+    double verifier_cpu_seconds = 0;
+    int failures = 0;
+};
+
+double GetThreadCpuSeconds() {
+    timespec time{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_nsec) * 1e-9;
+}
+
+/// Adds the thread CPU time spent in the scope to the counter.
+class CpuTimer {
+  public:
+    explicit CpuTimer(double& counter) : counter_(counter), start_(GetThreadCpuSeconds()) {}
+    ~CpuTimer() {
+        counter_ += GetThreadCpuSeconds() - start_;
+    }
+
+  private:
+    double& counter_;
+    double start_;
+};
+
+struct Session {
+    User user;
+    SessionId session_id;
+    std::chrono::steady_clock::time_point start_time;
+};
+
+Options ParseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string option = argv[i];
+        const int value = std::atoi(argv[i + 1]);
+        if (option == "--metrics" && (std::string(argv[i + 1]) == "json" ||
+                                      std::string(argv[i + 1]) == "prometheus")) {
+            options.metrics_format = argv[i + 1];
+        } else if (option == "--trace") {
+            options.trace_path = argv[i + 1];
+        } else if (option == "--key-store") {
+            options.key_store_path = argv[i + 1];
+        } else if (option == "--modulus-bits") {
+            options.modulus_bitness = std::max(8, value);
+        } else if (option == "--rounds") {
+            options.rounds = static_cast<uint32_t>(std::max(1, value));
+        } else if (option == "--users") {
+            options.users = std::max(1, value);
+        } else if (option == "--sessions") {
+            options.concurrent_sessions = std::max(1, value);
+        } else if (option == "--authentications") {
+            options.authentications = std::max(1, value);
+        } else if (option == "--threads") {
+            options.threads = std::max(1, value);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--modulus-bits B] [--rounds T] [--users N] "
+                      << "[--sessions M] [--authentications A] [--threads K] "
+                      << "[--metrics json|prometheus] [--trace FILE] [--key-store FILE]" << std::endl;
+            std::exit(1);
+        }
+    }
+    return options;
+}
+
+void RunWorker(const Options& options, int thread_id, const std::vector<User>& users,
+               VerifierService& verifier, std::atomic<int>& next_authentication, ThreadStats& stats) {
+    const int sessions_limit = std::max(1, options.concurrent_sessions / options.threads +
+                                           (thread_id < options.concurrent_sessions % options.threads ? 1 : 0));
+    std::vector<std::optional<Session>> sessions(sessions_limit);
+
+    auto start_session = [&](std::optional<Session>& slot) {
+        slot.reset();
+        const int authentication = next_authentication++;
+        if (authentication >= options.authentications) {
+            return;
+        }
+
+        const User& user = users[authentication % users.size()];
+        const auto start_time = std::chrono::steady_clock::now();
+        std::optional<SessionId> session_id;
+        {
+            CpuTimer timer(stats.verifier_cpu_seconds);
+            session_id = verifier.beginSession(user.getUserId());
+        }
+        if (!session_id.has_value()) {
+            ++stats.failures;
+            return;
+        }
+        slot.emplace(Session{user, session_id.value(), start_time});
+    };
+
+    for (auto& slot : sessions) {
+        start_session(slot);
+    }
+
+    bool has_active_sessions = true;
+    while (has_active_sessions) {
+        has_active_sessions = false;
+
+        for (auto& slot : sessions) {
+            if (!slot.has_value()) {
+                continue;
+            }
+            has_active_sessions = true;
+
+            Session& session = slot.value();
+            std::optional<BigInteger> response;
+            RoundResult result = RoundResult::REJECTED;
+            {
+                BigInteger commitment;
+                {
+                    CpuTimer timer(stats.prover_cpu_seconds);
+                    commitment = session.user.initAuthentication();
+                }
+
+                std::optional<bool> challenge;
+                {
+                    CpuTimer timer(stats.verifier_cpu_seconds);
+                    challenge = verifier.submitCommitment(session.session_id, commitment);
+                }
+
+                if (challenge.has_value()) {
+                    CpuTimer timer(stats.prover_cpu_seconds);
+                    response = session.user.processChallenge(challenge.value());
+                }
+
+                if (response.has_value()) {
+                    CpuTimer timer(stats.verifier_cpu_seconds);
+                    result = verifier.submitResponse(session.session_id, response.value());
+                }
+            }
+
+            if (result == RoundResult::CONTINUE) {
+                continue;
+            }
+            if (result != RoundResult::ACCEPTED) {
+                ++stats.failures;
+            }
+
+            const auto end_time = std::chrono::steady_clock::now();
+            stats.latencies_us.push_back(std::chrono::duration<double, std::micro>(end_time - session.start_time).count());
+            start_session(slot);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    const Options options = ParseOptions(argc, argv);
+
+    Crypto::RandomSeedInitialization();
+    if (!options.trace_path.empty()) {
+        Tracing::Enable();
+    }
+
+    CentralAuthority ca(options.modulus_bitness / 2);
+
+    std::vector<User> users;
+    std::vector<std::pair<std::string, BigInteger>> public_keys;
+    users.reserve(options.users);
+    for (int i = 0; i < options.users; ++i) {
+        users.emplace_back("user-" + std::to_string(i), ca.getModule());
+        public_keys.emplace_back(users.back().getUserId(), users.back().getPublicKey());
+    }
+    ca.registerUsers(public_keys);
+
+    std::unique_ptr<CentralAuthority> stored_ca;
+    if (!options.key_store_path.empty()) {
+        if (!ca.saveKeyStore(options.key_store_path) ||
+            !(stored_ca = CentralAuthority::fromKeyStore(options.key_store_path))) {
+            std::cerr << "Can't use key store '" << options.key_store_path << "'" << std::endl;
+            return 1;
+        }
+    }
+
+    VerifierService verifier(stored_ca ? *stored_ca : ca, options.rounds);
+
+    std::atomic<int> next_authentication{0};
+    std::vector<ThreadStats> stats(options.threads);
+
+    const auto start_time = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int thread_id = 0; thread_id < options.threads; ++thread_id) {
+        workers.emplace_back(RunWorker, std::cref(options), thread_id, std::cref(users),
+                             std::ref(verifier), std::ref(next_authentication), std::ref(stats[thread_id]));
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const double total_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+    ThreadStats total;
+    for (const auto& thread_stats : stats) {
+        total.latencies_us.insert(total.latencies_us.end(),
+                                  thread_stats.latencies_us.begin(), thread_stats.latencies_us.end());
+        total.prover_cpu_seconds += thread_stats.prover_cpu_seconds;
+        total.verifier_cpu_seconds += thread_stats.verifier_cpu_seconds;
+        total.failures += thread_stats.failures;
+    }
+    std::sort(total.latencies_us.begin(), total.latencies_us.end());
+
+    auto percentile = [&total](double p) {
+        if (total.latencies_us.empty()) {
+            return 0.0;
+        }
+        return total.latencies_us[static_cast<size_t>(p * static_cast<double>(total.latencies_us.size() - 1))];
+    };
+    const double cpu_seconds = std::max(1e-9, total.prover_cpu_seconds + total.verifier_cpu_seconds);
+
+    printf("modulus_bits=%d rounds=%u users=%d sessions=%d threads=%d keys=%s\n",
+           options.modulus_bitness, options.rounds, options.users, options.concurrent_sessions, options.threads,
+           stored_ca ? "store" : "memory");
+    printf("authentications: %d, failed: %d, wall time: %.3f s\n",
+           options.authentications, total.failures, total_seconds);
+    printf("throughput: %.1f authentications/s\n", options.authentications / total_seconds);
+    printf("latency: p50 = %.1f us, p99 = %.1f us, p999 = %.1f us\n",
+           percentile(0.5), percentile(0.99), percentile(0.999));
+    printf("cpu: prover = %.3f s (%.1f%%), verifier = %.3f s (%.1f%%)\n",
+           total.prover_cpu_seconds, 100 * total.prover_cpu_seconds / cpu_seconds,
+           total.verifier_cpu_seconds, 100 * total.verifier_cpu_seconds / cpu_seconds);
+
+    if (options.metrics_format == "json") {
+        std::cout << Instrumentation::ExportJson();
+    } else if (options.metrics_format == "prometheus") {
+        std::cout << Instrumentation::ExportPrometheus();
+    }
+
+    if (!options.trace_path.empty() && !Tracing::WriteChromeTrace(options.trace_path)) {
+        std::cerr << "Can't write trace to '" << options.trace_path << "'" << std::endl;
+        return 1;
+    }
+
+    return total.failures == 0 ? 0 : 1;
+}
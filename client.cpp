@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AuthenticationClient.h"
+#include "User.h"
+
+#include "crypto_algorithms.h"
+
+
+struct Options {
+    std::string unix_path;
+    int tcp_port = -1;
+    int users = 16;
+    int authentications = 1000;
+    int threads = 4;
+    /// Three messages per authentication instead of 3t; rounds has to match the server's --rounds.
+    bool pipelined = false;
+    uint32_t rounds = 30;
+};
+
+std::unique_ptr<AuthenticationClient> Connect(const Options& options) {
+    return options.unix_path.empty() ? AuthenticationClient::connectTcp(static_cast<uint16_t>(options.tcp_port))
+                                     : AuthenticationClient::connectUnix(options.unix_path);
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string option = argv[i];
+        if (option == "--pipelined") {
+            options.pipelined = true;
+            continue;
+        }
+        if (i + 1 == argc) {
+            break;
+        }
+        if (option == "--unix") {
+            options.unix_path = argv[i + 1];
+        } else if (option == "--tcp") {
+            options.tcp_port = std::atoi(argv[i + 1]);
+        } else if (option == "--users") {
+            options.users = std::max(1, std::atoi(argv[i + 1]));
+        } else if (option == "--authentications") {
+            options.authentications = std::atoi(argv[i + 1]);
+        } else if (option == "--threads") {
+            options.threads = std::max(1, std::atoi(argv[i + 1]));
+        } else if (option == "--rounds") {
+            options.rounds = static_cast<uint32_t>(std::max(1, std::atoi(argv[i + 1])));
+        }
+        ++i;
+    }
+    if (options.unix_path.empty() == (options.tcp_port < 0)) {
+        std::cerr << "Usage: " << argv[0] << " (--unix PATH | --tcp PORT) [--users U] "
+                  << "[--authentications N] [--threads T] [--pipelined [--rounds T]]" << std::endl;
+        return 1;
+    }
+
+    Crypto::RandomSeedInitialization();
+
+    auto client = Connect(options);
+    const auto module = client ? client->requestModule() : std::nullopt;
+    if (!module.has_value()) {
+        std::cerr << "Error: Can't reach the server." << std::endl;
+        return 1;
+    }
+
+    const std::string id_prefix = "client-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    std::vector<User> users;
+    for (int i = 0; i < options.users; ++i) {
+        users.emplace_back(id_prefix + "-" + std::to_string(i), module.value());
+        if (!client->registerUser(users.back())) {
+            std::cerr << "Error: Can't register user '" << users.back().getUserId()
+                      << "' (registration needs a server started with --allow-register)." << std::endl;
+            return 1;
+        }
+    }
+
+    /// Each authentication opens its own connection, so this measures connections per second too.
+    std::atomic<int> next_authentication{0};
+    std::atomic<int> failures{0};
+    std::vector<std::vector<double>> latencies(options.threads);
+
+    const auto start_time = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int thread_id = 0; thread_id < options.threads; ++thread_id) {
+        workers.emplace_back([&, thread_id]() {
+            for (int i = next_authentication++; i < options.authentications; i = next_authentication++) {
+                User user = users[i % users.size()];
+
+                const auto begin = std::chrono::steady_clock::now();
+                auto connection = Connect(options);
+                const bool is_accepted = connection && (options.pipelined
+                        ? connection->authenticatePipelined(user, options.rounds)
+                        : connection->authenticate(user));
+                if (!is_accepted) {
+                    ++failures;
+                }
+                const auto end = std::chrono::steady_clock::now();
+
+                latencies[thread_id].push_back(std::chrono::duration<double, std::micro>(end - begin).count());
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const double total_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+    std::vector<double> all_latencies;
+    for (const auto& thread_latencies : latencies) {
+        all_latencies.insert(all_latencies.end(), thread_latencies.begin(), thread_latencies.end());
+    }
+    std::sort(all_latencies.begin(), all_latencies.end());
+    auto percentile = [&all_latencies](double p) {
+        return all_latencies.empty() ? 0.0 : all_latencies[static_cast<size_t>(p * (all_latencies.size() - 1))];
+    };
+
+    printf("Authentications: %d, failed: %d\n", options.authentications, failures.load());
+    printf("Throughput: %.1f authentications/s\n", options.authentications / total_seconds);
+    printf("Latency: p50 = %.1f us, p99 = %.1f us\n", percentile(0.5), percentile(0.99));
+
+    return failures.load() == 0 ? 0 : 1;
+}
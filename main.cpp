@@ -5,8 +5,13 @@
 #include <iostream>
 #include <random>
 
+#include "AuthenticationCoroutines.h"
 #include "CentralAuthority.h"
+#include "Executor.h"
+#include "InMemoryTransport.h"
 #include "User.h"
+#include "VerifierService.h"
+#include "WireFormat.h"
 
 #include "crypto_algorithms.h"
 
@@ -16,28 +21,48 @@ const char* kAliceUserId = "Alice";
 constexpr uint32_t kNumberOfTests = 30;
 
 
-bool VerifyUser(const CentralAuthority& ca, User& user, const std::string user_id) {
-    const auto& user_public_key = ca.getUserPublicKey(user_id);
+/// Decodes the message that was written into the channel by the other party.
+template <typename Decoder>
+auto ReceiveMessage(const Wire::Writer& channel, Decoder decode) {
+    Wire::Reader reader(channel.data());
+    const auto message = reader.next();
+
+    return message.has_value() ? decode(message.value())
+                               : decltype(decode(message.value())){};
+}
 
-    if (!user_public_key.has_value()) {
+bool VerifyUser(const CentralAuthority& ca, User& user, const std::string user_id) {
+    if (ca.getUserPublicKey(user_id) == nullptr) {
         std::cerr << "User doesn't exist." << std::endl;
         return false;
     }
 
+    Wire::Writer channel;
     for (uint32_t i = 0; i < kNumberOfTests; ++i) {
-        BigInteger x = user.initAuthentication();
+        channel.clear();
+        channel.writeCommitment(user.initAuthentication());
+        const auto x = ReceiveMessage(channel, Wire::DecodeCommitment);
+
+        bool e = Crypto::GetSecureRandomBit();
+        channel.clear();
+        channel.writeChallenge({e});
+        const auto challenge = ReceiveMessage(channel, Wire::DecodeChallenge);
+
+        if (!x.has_value() || !challenge.has_value() || challenge->size() != 1) {
+            return false;
+        }
 
-        bool e = (rand() & 1);
-        const auto& y = user.processChallenge(e);
+        const auto& y = user.processChallenge(challenge->front());
 
         if (!y.has_value()) {
             return false;
         }
 
-        BigInteger expected_value = e ? (x * user_public_key.value()) % ca.getModule()
-                                      : x;
+        channel.clear();
+        channel.writeResponse(y.value());
+        const auto response = ReceiveMessage(channel, Wire::DecodeResponse);
 
-        if (expected_value != (y.value() * y.value()) % ca.getModule()) {
+        if (!response.has_value() || !ca.verifyTranscript({user_id, x.value(), e, response.value()})) {
             return false;
         }
     }
@@ -47,6 +72,104 @@ bool VerifyUser(const CentralAuthority& ca, User& user, const std::string user_i
     return true;
 }
 
+/// Three messages instead of 3t: all commitments, all challenge bits, all responses.
+bool VerifyUserPipelined(const CentralAuthority& ca, User& user, const std::string user_id) {
+    Wire::Writer channel;
+    channel.writeCommitments(user.initAuthentication(kNumberOfTests));
+
+    const auto commitments = ReceiveMessage(channel, Wire::DecodeCommitments);
+    if (!commitments.has_value()) {
+        return false;
+    }
+
+    std::vector<bool> challenges(commitments->size());
+    for (size_t i = 0; i < challenges.size(); ++i) {
+        challenges[i] = Crypto::GetSecureRandomBit();
+    }
+    channel.clear();
+    channel.writeChallenge(challenges);
+
+    const auto received_challenges = ReceiveMessage(channel, Wire::DecodeChallenge);
+    const auto y = received_challenges.has_value() ? user.processChallenges(received_challenges.value())
+                                                   : std::nullopt;
+    if (!y.has_value()) {
+        return false;
+    }
+
+    channel.clear();
+    channel.writeResponses(y.value());
+
+    const auto responses = ReceiveMessage(channel, Wire::DecodeResponses);
+    if (!responses.has_value()) {
+        return false;
+    }
+
+    if (!ca.verifyRounds(user_id, commitments.value(), challenges, responses.value())) {
+        return false;
+    }
+
+    printf("User '%s' passed t=%d pipelined tests and has successfully authorized.\n", user_id.c_str(), kNumberOfTests);
+
+    return true;
+}
+
+/// The prover and verifier coroutines exchange Wire frames over an in-memory connection.
+bool VerifyUserAsync(const CentralAuthority& ca, User& user) {
+    Executor executor;
+    auto [prover_endpoint, verifier_endpoint] = MakeInMemoryConnection(executor);
+
+    auto is_proved = executor.spawn(RunProver(user, std::move(prover_endpoint)));
+    auto is_accepted = executor.spawn(RunVerifier(ca, std::move(verifier_endpoint), kNumberOfTests));
+    executor.run();
+
+    if (!is_proved.get() || !is_accepted.get()) {
+        return false;
+    }
+
+    printf("User '%s' passed t=%d tests over the in-memory transport and has successfully authorized.\n",
+           user.getUserId().c_str(), kNumberOfTests);
+
+    return true;
+}
+
+/// x = y = 0 satisfies y^2 == x * v^e for both challenges, so it must never pass a round.
+bool RejectsZeroTranscript(const CentralAuthority& ca, const std::string user_id) {
+    const BigInteger zero(0);
+    const BigInteger* public_key = ca.getUserPublicKey(user_id);
+
+    if (public_key == nullptr || ca.verifyRound(*public_key, zero, false, zero) ||
+        ca.verifyRound(*public_key, zero, true, zero)) {
+        return false;
+    }
+
+    VerifierService verifier(ca, kNumberOfTests);
+    const auto session_id = verifier.beginSession(user_id);
+
+    return session_id.has_value() &&
+           verifier.submitCommitment(session_id.value(), zero).has_value() &&
+           verifier.submitResponse(session_id.value(), zero) == RoundResult::REJECTED;
+}
+
+/// One transcript with a changed response among valid ones: verifyBatch must reject exactly that one.
+bool IsolatesTamperedTranscript(const CentralAuthority& ca, User& user) {
+    std::vector<AuthenticationTranscript> transcripts;
+    for (uint32_t i = 0; i < kNumberOfTests; ++i) {
+        const BigInteger x = user.initAuthentication();
+        const bool e = Crypto::GetSecureRandomBit();
+        const auto y = user.processChallenge(e);
+        if (!y.has_value()) {
+            return false;
+        }
+        transcripts.push_back({user.getUserId(), x, e, y.value()});
+    }
+
+    const size_t tampered_index = kNumberOfTests / 3;
+    auto& tampered = transcripts[tampered_index].response;
+    tampered = tampered + 1 < ca.getModule() ? tampered + 1 : BigInteger(1);
+
+    return ca.verifyBatch(transcripts) == std::vector<size_t>{tampered_index};
+}
+
 int main() {
     Crypto::RandomSeedInitialization();
 
@@ -61,5 +184,23 @@ int main() {
         printf("Failed to successfully authorize user '%s'.\n", kAliceUserId);
     }
 
+    if (!VerifyUserPipelined(ca, alice, kAliceUserId)) {
+        printf("Failed to successfully authorize user '%s' in pipelined mode.\n", kAliceUserId);
+    }
+
+    if (!VerifyUserAsync(ca, alice)) {
+        printf("Failed to successfully authorize user '%s' over the in-memory transport.\n", kAliceUserId);
+    }
+
+    if (!RejectsZeroTranscript(ca, kAliceUserId)) {
+        printf("Error: the all-zero transcript was accepted for user '%s'.\n", kAliceUserId);
+        return 1;
+    }
+
+    if (!IsolatesTamperedTranscript(ca, alice)) {
+        printf("Error: batch verification didn't isolate the tampered transcript of user '%s'.\n", kAliceUserId);
+        return 1;
+    }
+
     return 0;
 }
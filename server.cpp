@@ -0,0 +1,84 @@
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "AuthenticationServer.h"
+#include "CentralAuthority.h"
+#include "VerifierService.h"
+
+#include "crypto_algorithms.h"
+#include "tracing.h"
+
+
+AuthenticationServer* server_instance = nullptr;
+
+void StopServer(int) {
+    if (server_instance) {
+        server_instance->stop();
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string unix_path;
+    int tcp_port = -1;
+    uint32_t rounds = 30;
+    std::string trace_path;
+    bool allow_registration = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string option = argv[i];
+        if (option == "--allow-register") {
+            allow_registration = true;
+            continue;
+        }
+        if (i + 1 == argc) {
+            break;
+        }
+        if (option == "--unix") {
+            unix_path = argv[i + 1];
+        } else if (option == "--tcp") {
+            tcp_port = std::atoi(argv[i + 1]);
+        } else if (option == "--rounds") {
+            rounds = static_cast<uint32_t>(std::atoi(argv[i + 1]));
+        } else if (option == "--trace") {
+            trace_path = argv[i + 1];
+        }
+        ++i;
+    }
+    if (unix_path.empty() == (tcp_port < 0)) {
+        std::cerr << "Usage: " << argv[0] << " (--unix PATH | --tcp PORT) [--rounds T] [--trace FILE] [--allow-register]" << std::endl;
+        return 1;
+    }
+
+    Crypto::RandomSeedInitialization();
+    if (!trace_path.empty()) {
+        Tracing::Enable();
+    }
+
+    CentralAuthority ca;
+    VerifierService verifier(ca, rounds);
+    AuthenticationServer server(ca, verifier, allow_registration);
+
+    if (!(unix_path.empty() ? server.listenTcp(static_cast<uint16_t>(tcp_port)) : server.listenUnix(unix_path))) {
+        return 1;
+    }
+
+    server_instance = &server;
+    std::signal(SIGINT, StopServer);
+    std::signal(SIGTERM, StopServer);
+
+    printf("Module N = %s\n", ca.getModule().ToString().c_str());
+    printf("Listening, t=%d rounds per authentication.\n", rounds);
+    if (allow_registration) {
+        printf("Warning: anyone who can connect may register users.\n");
+    }
+    server.run();
+
+    if (!trace_path.empty() && !Tracing::WriteChromeTrace(trace_path)) {
+        std::cerr << "Can't write trace to '" << trace_path << "'" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}